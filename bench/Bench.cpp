@@ -0,0 +1,420 @@
+#include "SentimentClassifier.h"
+#include "ScoringMatrix.h"
+#include "Tokenizer.h"
+#include "CsvReader.h"
+#include "Arena.h"
+#include "Vocabulary.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Microbenchmarks for the classifier's hot paths plus end-to-end throughput.
+ *
+ * Usage: bench [--filter STR] [--repetitions N] [--min-time MS] [--threads N]
+ *              [--train FILE] [--test FILE]
+ *
+ * Every benchmark is calibrated until one repetition runs for at least
+ * --min-time milliseconds (default 100), then repeated --repetitions times
+ * (default 5). Inputs are the words and tweets of the bundled datasets, so
+ * runs are repeatable. One CSV row per benchmark goes to stdout:
+ *
+ *   benchmark,ops,repetitions,median_ns_per_op,min_ns_per_op,items_per_s,mb_per_s
+ *
+ * An op is one call for the microbenchmarks and one whole file for train/predict,
+ * where items are tweets; items_per_s and mb_per_s use the median repetition.
+ * Configure with -DCMAKE_BUILD_TYPE=Release before comparing numbers.
+ */
+
+using Clock = std::chrono::steady_clock;
+
+// Keeps the compiler from discarding a result it can prove is unused
+template <typename T>
+static inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct Options {
+    std::string filter;
+    int repetitions = 5;
+    double minTimeMs = 100;
+    unsigned threads = 1;
+    const char* trainPath = "data/train_dataset_20k.csv";
+    const char* testPath = "data/test_dataset_10k.csv";
+};
+
+// A benchmark body runs `ops` operations and returns the items and bytes they covered
+struct Work {
+    double items;
+    double bytes;
+};
+using Body = std::function<Work(size_t ops)>;
+
+static void run(const Options& options, const char* name, const Body& body) {
+    if (!options.filter.empty() && std::string(name).find(options.filter) == std::string::npos) {
+        return;
+    }
+
+    // Calibrate: grow the op count until one repetition is long enough to time
+    size_t ops = 1;
+    for (;;) {
+        auto start = Clock::now();
+        body(ops);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        if (ms >= options.minTimeMs || ops >= (size_t(1) << 40)) break;
+        size_t next = ms > 0 ? static_cast<size_t>(ops * options.minTimeMs * 1.2 / ms) : ops * 10;
+        ops = std::min(std::max(next, ops * 2), size_t(1) << 40);
+    }
+
+    std::vector<double> nsPerOp;
+    Work work{0, 0};
+    for (int r = 0; r < options.repetitions; r++) {
+        auto start = Clock::now();
+        work = body(ops);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        nsPerOp.push_back(ns / ops);
+    }
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+    double median = nsPerOp[nsPerOp.size() / 2];
+    double seconds = median * ops / 1e9;
+
+    std::cout << name << ',' << ops << ',' << options.repetitions << ',' << median << ','
+              << nsPerOp.front() << ',' << work.items / seconds << ','
+              << work.bytes / seconds / (1024.0 * 1024.0) << std::endl;
+}
+
+// The vocabulary hash before hashCharacters went word-at-a-time:
+// byte-at-a-time DJB2 followed by a 64-bit finalizer
+static uint64_t hashDjb2(const char* ptr, size_t len) {
+    uint64_t hash = 5381;
+    for (size_t i = 0; i < len; i++) {
+        hash = ((hash << 5) + hash) + ptr[i];
+    }
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// Vocabulary's slot table and probing rebuilt over its words with a chosen
+// hash function, so lookups can be compared across hash functions
+template <uint64_t (*Hash)(const char*, size_t)>
+class SlotIndex {
+public:
+    explicit SlotIndex(const Vocabulary& vocabulary) : words(vocabulary) {
+        size_t numSlots = 1024;
+        while (vocabulary.size() * 10 >= numSlots * 7) numSlots *= 2;
+        slots.assign(numSlots, Vocabulary::Slot{Vocabulary::NOT_FOUND, 0});
+        mask = numSlots - 1;
+        for (uint32_t id = 0; id < vocabulary.size(); id++) {
+            DSStringView word = vocabulary.word(id);
+            uint64_t hash = Hash(word.data(), word.getLength());
+            size_t index = static_cast<size_t>(hash) & mask;
+            while (slots[index].id != Vocabulary::NOT_FOUND) index = (index + 1) & mask;
+            slots[index] = Vocabulary::Slot{id, static_cast<uint32_t>(hash >> 32)};
+        }
+    }
+
+    uint32_t find(DSStringView word) const {
+        uint64_t hash = Hash(word.data(), word.getLength());
+        uint32_t tag = static_cast<uint32_t>(hash >> 32);
+        for (size_t index = static_cast<size_t>(hash) & mask;; index = (index + 1) & mask) {
+            const Vocabulary::Slot& slot = slots[index];
+            if (slot.id == Vocabulary::NOT_FOUND) return slot.id;
+            if (slot.tag == tag && words.word(slot.id) == word) return slot.id;
+        }
+    }
+
+private:
+    const Vocabulary& words;
+    std::vector<Vocabulary::Slot> slots;
+    size_t mask;
+};
+
+// Tweet texts of a CSV file; textField is the index of the tweet column
+static std::vector<DSStringView> loadTexts(const MappedFile& file, size_t textField, std::vector<bool>* labels) {
+    std::vector<DSStringView> texts;
+    CsvReader reader(file);
+    CsvField line;
+    reader.nextLine(line);  // Header
+    while (reader.nextLine(line)) {
+        CsvField fields[6];
+        CsvReader::splitFields(line, fields, textField + 1);
+        CsvField text = fields[textField].unquoted();
+        texts.push_back(DSStringView(text.data, text.length));
+        if (labels) labels->push_back(fields[0].equals("4"));
+    }
+    return texts;
+}
+
+static size_t countRows(const MappedFile& file) {
+    size_t rows = static_cast<size_t>(std::count(file.data(), file.data() + file.size(), '\n'));
+    if (file.size() > 0 && file.data()[file.size() - 1] != '\n') rows++;
+    return rows > 0 ? rows - 1 : 0;  // Header
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "Missing value for " << arg << std::endl;
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (arg == "--filter") options.filter = value;
+        else if (arg == "--repetitions") options.repetitions = std::max(1, std::stoi(value));
+        else if (arg == "--min-time") options.minTimeMs = std::stod(value);
+        else if (arg == "--threads") options.threads = static_cast<unsigned>(std::stoul(value));
+        else if (arg == "--train") options.trainPath = value;
+        else if (arg == "--test") options.testPath = value;
+        else {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        MappedFile trainFile(options.trainPath);
+        MappedFile testFile(options.testPath);
+        if (!trainFile.is_open() || !testFile.is_open()) {
+            throw std::runtime_error("Unable to open the training or test file");
+        }
+
+        // Benchmark inputs, all taken from the training set
+        SentimentClassifier classifier;
+        std::vector<bool> labels;
+        std::vector<DSStringView> texts = loadTexts(trainFile, 5, &labels);
+        std::vector<DSStringView> tokens;
+        std::vector<DSString> words;
+        std::vector<bool> wordLabels;
+        for (size_t t = 0; t < texts.size(); t++) {
+            for (const auto& token : classifier.tokenize(texts[t])) {
+                tokens.push_back(token);
+                DSString word = classifier.preprocessWord(token);
+                if (word.getLength() > 0) {
+                    words.push_back(std::move(word));
+                    wordLabels.push_back(labels[t]);
+                }
+            }
+        }
+        std::vector<DSString> longTexts;
+        for (const auto& text : texts) longTexts.push_back(text.toString());
+
+        std::cout << "benchmark,ops,repetitions,median_ns_per_op,min_ns_per_op,items_per_s,mb_per_s" << std::endl;
+
+        // Cycles through inputs, feeding each to fn; items = ops, bytes from size(input)
+        auto perInput = [](const auto& inputs, auto fn, auto size) {
+            return [&inputs, fn, size](size_t ops) {
+                double bytes = 0;
+                for (size_t i = 0, k = 0; i < ops; i++, k = k + 1 == inputs.size() ? 0 : k + 1) {
+                    fn(inputs[k]);
+                    bytes += size(inputs[k]);
+                }
+                return Work{static_cast<double>(ops), bytes};
+            };
+        };
+        auto viewSize = [](const DSStringView& view) { return static_cast<double>(view.getLength()); };
+        auto stringSize = [](const DSString& str) { return static_cast<double>(str.getLength()); };
+
+        // DSString
+        run(options, "dsstring_construct_word", perInput(tokens, [](const DSStringView& token) {
+            DSString str(token.data(), token.getLength());
+            doNotOptimize(str);
+        }, viewSize));
+        run(options, "dsstring_construct_tweet", perInput(texts, [](const DSStringView& text) {
+            DSString str(text.data(), text.getLength());
+            doNotOptimize(str);
+        }, viewSize));
+        run(options, "dsstring_copy_word", perInput(words, [](const DSString& word) {
+            DSString copy(word);
+            doNotOptimize(copy);
+        }, stringSize));
+        run(options, "dsstring_copy_tweet", perInput(longTexts, [](const DSString& text) {
+            DSString copy(text);
+            doNotOptimize(copy);
+        }, stringSize));
+        run(options, "dsstring_hash_word", perInput(words, [](const DSString& word) {
+            size_t hash = std::hash<DSString>()(word);  // Cached after the first round
+            doNotOptimize(hash);
+        }, stringSize));
+
+        // Hashing and table lookups, DJB2 vs. the word-at-a-time hash. Lookups
+        // take the test set's words, so they mix hits and misses like predict.
+        std::vector<DSString> testWords;
+        Tokenizer wordSplitter;
+        for (const auto& text : loadTexts(testFile, 4, nullptr)) {
+            for (const Token& token : wordSplitter.run(text)) {
+                if (!token.word.empty()) testWords.push_back(token.word.toString());
+            }
+        }
+        Vocabulary trainVocabulary;
+        for (const auto& word : words) trainVocabulary.intern(word);
+        run(options, "hash_word_djb2", perInput(words, [](const DSString& word) {
+            uint64_t hash = hashDjb2(word.c_str(), word.getLength());
+            doNotOptimize(hash);
+        }, stringSize));
+        run(options, "hash_word", perInput(words, [](const DSString& word) {
+            uint64_t hash = hashCharacters(word.c_str(), word.getLength());
+            doNotOptimize(hash);
+        }, stringSize));
+        SlotIndex<hashDjb2> djb2Index(trainVocabulary);
+        SlotIndex<hashCharacters> wordIndex(trainVocabulary);
+        run(options, "lookup_djb2", perInput(testWords, [&djb2Index](const DSString& word) {
+            uint32_t id = djb2Index.find(word);
+            doNotOptimize(id);
+        }, stringSize));
+        run(options, "lookup", perInput(testWords, [&wordIndex](const DSString& word) {
+            uint32_t id = wordIndex.find(word);
+            doNotOptimize(id);
+        }, stringSize));
+        run(options, "vocabulary_find", perInput(testWords, [&trainVocabulary](const DSString& word) {
+            uint32_t id = trainVocabulary.find(word);
+            doNotOptimize(id);
+        }, stringSize));
+
+        // Text processing
+        run(options, "tokenize", perInput(texts, [&classifier](const DSStringView& text) {
+            std::vector<DSStringView> split = classifier.tokenize(text);
+            doNotOptimize(split);
+        }, viewSize));
+        Tokenizer tokenizer;
+        run(options, "tokenizer_run", perInput(texts, [&tokenizer](const DSStringView& text) {
+            const std::vector<Token>& split = tokenizer.run(text);
+            doNotOptimize(split);
+        }, viewSize));
+        run(options, "preprocess_word", perInput(tokens, [&classifier](const DSStringView& token) {
+            DSString word = classifier.preprocessWord(token);
+            doNotOptimize(word);
+        }, viewSize));
+        run(options, "is_stop_word", perInput(tokens, [](const DSStringView& token) {
+            bool stop = isStopWord(token);
+            doNotOptimize(stop);
+        }, viewSize));
+        
+        // Whole reference path for one tweet, with and without a per-tweet arena
+        auto referenceTweet = [&classifier](const DSStringView& text) {
+            for (const auto& token : classifier.tokenize(text)) {
+                DSString word = classifier.preprocessWord(token);
+                doNotOptimize(word);
+            }
+        };
+        run(options, "reference_tweet", perInput(texts, referenceTweet, viewSize));
+        Arena arena;
+        run(options, "reference_tweet_arena", perInput(texts, [&arena, referenceTweet](const DSStringView& text) {
+            ArenaScope scope(arena);
+            referenceTweet(text);
+        }, viewSize));
+
+        // Model updates; the table reaches its full size during calibration
+        SentimentClassifier counter;
+        run(options, "update_word_frequency", [&](size_t ops) {
+            double bytes = 0;
+            for (size_t i = 0, k = 0; i < ops; i++, k = k + 1 == words.size() ? 0 : k + 1) {
+                counter.updateWordFrequency(words[k], wordLabels[k]);
+                bytes += words[k].getLength();
+            }
+            return Work{static_cast<double>(ops), bytes};
+        });
+
+        // End to end, one op per file
+        double trainRows = static_cast<double>(countRows(trainFile));
+        double testRows = static_cast<double>(countRows(testFile));
+        run(options, "train", [&](size_t ops) {
+            for (size_t i = 0; i < ops; i++) {
+                SentimentClassifier model;
+                model.setThreads(options.threads);
+                model.train(options.trainPath);
+                doNotOptimize(model);
+            }
+            return Work{trainRows * ops, static_cast<double>(trainFile.size()) * ops};
+        });
+        SentimentClassifier model;
+        model.setThreads(options.threads);
+        model.train(options.trainPath);
+        model.freeze();
+        const char* predictionsPath = "bench_predictions.csv";
+        run(options, "predict", [&](size_t ops) {
+            for (size_t i = 0; i < ops; i++) {
+                model.predict(options.testPath, predictionsPath);
+            }
+            return Work{testRows * ops, static_cast<double>(testFile.size()) * ops};
+        });
+
+        // Scoring alone, per tweet vs. in batches; a batch op is one pass over
+        // the test tweets, so compare items_per_s. score_matrix_* leave out
+        // tokenizing and word lookups (the matrix is built beforehand).
+        std::vector<DSStringView> testTexts = loadTexts(testFile, 4, nullptr);
+        run(options, "classify_tweet", perInput(testTexts, [&model](const DSStringView& text) {
+            doNotOptimize(model.classify(text));
+        }, viewSize));
+        std::vector<int> batchResults(testTexts.size());
+        ScoringMatrix matrix;
+        run(options, "classify_batch", [&](size_t ops) {
+            const size_t BATCH_SIZE = 4096;
+            for (size_t i = 0; i < ops; i++) {
+                for (size_t first = 0; first < testTexts.size(); first += BATCH_SIZE) {
+                    size_t count = std::min(BATCH_SIZE, testTexts.size() - first);
+                    model.classifyBatch(testTexts.data() + first, count, batchResults.data() + first, matrix);
+                }
+                doNotOptimize(batchResults);
+            }
+            return Work{static_cast<double>(testTexts.size() * ops), static_cast<double>(testFile.size() * ops)};
+        });
+        model.classifyBatch(testTexts.data(), testTexts.size(), batchResults.data(), matrix);
+        // The frozen weights, pos / (pos + neg + 1) per word and 0 for unseen words
+        std::vector<WordWeight> weights(model.getVocabulary().size() + 1, WordWeight{0, 0});
+        for (uint32_t id = 0; id < model.getVocabulary().size(); id++) {
+            const WordCount& count = model.getVocabulary().counts(id);
+            double total = static_cast<double>(count.pos) + count.neg + 1;
+            weights[id] = WordWeight{count.pos / total, count.neg / total};
+        }
+        for (Tokenizer::Isa isa : {Tokenizer::Isa::Scalar, Tokenizer::Isa::AVX2}) {
+            if (!Tokenizer::isSupported(isa)) continue;
+            std::string name = std::string("score_matrix_") + Tokenizer::isaName(isa);
+            run(options, name.c_str(), [&](size_t ops) {
+                for (size_t i = 0; i < ops; i++) {
+                    matrix.score(weights.data(), model.getParams(), batchResults.data(), isa);
+                    doNotOptimize(batchResults);
+                }
+                return Work{static_cast<double>(matrix.numRows() * ops), 0};
+            });
+        }
+
+        // Same with hashed unigram + bigram features in 2^20 counters
+        const unsigned HASH_BITS = 20;
+        run(options, "train_hashed", [&](size_t ops) {
+            for (size_t i = 0; i < ops; i++) {
+                SentimentClassifier hashedModel;
+                hashedModel.setThreads(options.threads);
+                hashedModel.setFeatureHashing(HASH_BITS);
+                hashedModel.train(options.trainPath);
+                doNotOptimize(hashedModel);
+            }
+            return Work{trainRows * ops, static_cast<double>(trainFile.size()) * ops};
+        });
+        SentimentClassifier hashedModel;
+        hashedModel.setThreads(options.threads);
+        hashedModel.setFeatureHashing(HASH_BITS);
+        hashedModel.train(options.trainPath);
+        hashedModel.freeze();
+        run(options, "predict_hashed", [&](size_t ops) {
+            for (size_t i = 0; i < ops; i++) {
+                hashedModel.predict(options.testPath, predictionsPath);
+            }
+            return Work{testRows * ops, static_cast<double>(testFile.size()) * ops};
+        });
+        std::remove(predictionsPath);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
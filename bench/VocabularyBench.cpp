@@ -0,0 +1,178 @@
+#include "SentimentClassifier.h"
+#include "Vocabulary.h"
+#include "CsvReader.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Memory and lookup benchmark: interned flat Vocabulary vs. the previous
+ * pair of std::unordered_map<DSString, int> tables.
+ *
+ * Usage: vocab_bench [train_csv] [test_csv] [tweets ...]
+ * Defaults to the bundled datasets at 20k, 1M and 10M training tweets.
+ * Scales beyond the real corpus replay it, renaming every 16th word per
+ * replay so the vocabulary keeps growing like a real long-tail corpus.
+ */
+
+// Live heap bytes, tracked through replaced operator new/delete
+static size_t liveBytes = 0;
+
+void* operator new(size_t size) {
+    size_t* block = static_cast<size_t*>(std::malloc(size + 16));
+    if (!block) throw std::bad_alloc();
+    block[0] = size;
+    liveBytes += size;
+    return reinterpret_cast<char*>(block) + 16;
+}
+void operator delete(void* ptr) noexcept {
+    if (!ptr) return;
+    size_t* block = reinterpret_cast<size_t*>(static_cast<char*>(ptr) - 16);
+    liveBytes -= block[0];
+    std::free(block);
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+void operator delete(void* ptr, size_t) noexcept { operator delete(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { operator delete(ptr); }
+
+struct ProcessedTweet {
+    bool isPositive;
+    std::vector<DSString> words;
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double millisSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Tokenizes and preprocesses every row; textField is the index of the tweet column
+static std::vector<ProcessedTweet> loadTweets(const char* path, size_t textField) {
+    MappedFile file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error(std::string("Unable to open ") + path);
+    }
+    SentimentClassifier classifier;
+    std::vector<ProcessedTweet> tweets;
+    CsvReader reader(file);
+    CsvField line;
+    reader.nextLine(line);  // Header
+    while (reader.nextLine(line)) {
+        CsvField fields[6];
+        CsvReader::splitFields(line, fields, textField + 1);
+        CsvField text = fields[textField].unquoted();
+        ProcessedTweet tweet{fields[0].equals("4"), {}};
+        for (const auto& token : classifier.tokenize(DSStringView(text.data, text.length))) {
+            DSString word = classifier.preprocessWord(token);
+            if (word.getLength() > 0) tweet.words.push_back(std::move(word));
+        }
+        tweets.push_back(std::move(tweet));
+    }
+    return tweets;
+}
+
+// Calls visit(word, isPositive) for every word of a corpus of the requested size
+template <typename Visit>
+static void replay(const std::vector<ProcessedTweet>& base, size_t numTweets, Visit visit) {
+    for (size_t k = 0; k < numTweets; k++) {
+        const ProcessedTweet& tweet = base[k % base.size()];
+        size_t round = k / base.size();
+        for (size_t w = 0; w < tweet.words.size(); w++) {
+            if (round > 0 && w % 16 == 0) {
+                DSString renamed = tweet.words[w] + DSString(std::to_string(round).c_str());
+                visit(renamed, tweet.isPositive);
+            } else {
+                visit(tweet.words[w], tweet.isPositive);
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* trainPath = argc > 1 ? argv[1] : "data/train_dataset_20k.csv";
+    const char* testPath = argc > 2 ? argv[2] : "data/test_dataset_10k.csv";
+    std::vector<size_t> scales;
+    for (int i = 3; i < argc; i++) scales.push_back(std::strtoull(argv[i], nullptr, 10));
+    if (scales.empty()) scales = {20000, 1000000, 10000000};
+
+    try {
+        std::vector<ProcessedTweet> train = loadTweets(trainPath, 5);
+        std::vector<ProcessedTweet> test = loadTweets(testPath, 4);
+        size_t testWords = 0;
+        for (const auto& tweet : test) testWords += tweet.words.size();
+        const int LOOKUP_ROUNDS = 20;
+
+        std::cout << "tweets,structure,vocabulary,bytes,build_ms,lookup_ns" << std::endl;
+        for (size_t scale : scales) {
+            // Previous model: two node-based maps, both probed for each scored word
+            {
+                size_t before = liveBytes;
+                auto start = Clock::now();
+                auto* positive = new std::unordered_map<DSString, int>();
+                auto* negative = new std::unordered_map<DSString, int>();
+                replay(train, scale, [&](const DSString& word, bool isPositive) {
+                    if (isPositive) (*positive)[word]++; else (*negative)[word]++;
+                });
+                double buildMs = millisSince(start);
+                size_t bytes = liveBytes - before;
+
+                long long sink = 0;
+                start = Clock::now();
+                for (int r = 0; r < LOOKUP_ROUNDS; r++) {
+                    for (const auto& tweet : test) {
+                        for (const auto& word : tweet.words) {
+                            auto p = positive->find(word);
+                            auto n = negative->find(word);
+                            sink += (p != positive->end() ? p->second : 0) + (n != negative->end() ? n->second : 0);
+                        }
+                    }
+                }
+                double lookupNs = millisSince(start) * 1e6 / (double(testWords) * LOOKUP_ROUNDS);
+                size_t distinct = positive->size();
+                for (const auto& entry : *negative) distinct += positive->count(entry.first) ? 0 : 1;
+                std::cout << scale << ",unordered_map," << distinct << "," << bytes << ","
+                          << buildMs << "," << lookupNs << std::endl;
+                if (sink == -1) std::cerr << sink;
+                delete positive;
+                delete negative;
+            }
+            // Interned flat vocabulary: one probe per scored word
+            {
+                size_t before = liveBytes;
+                auto start = Clock::now();
+                auto* vocabulary = new Vocabulary();
+                replay(train, scale, [&](const DSString& word, bool isPositive) {
+                    vocabulary->add(word, isPositive ? 1 : 0, isPositive ? 0 : 1);
+                });
+                double buildMs = millisSince(start);
+                size_t bytes = liveBytes - before;
+
+                long long sink = 0;
+                start = Clock::now();
+                for (int r = 0; r < LOOKUP_ROUNDS; r++) {
+                    for (const auto& tweet : test) {
+                        for (const auto& word : tweet.words) {
+                            const WordCount* count = vocabulary->lookup(word);
+                            sink += count ? count->pos + count->neg : 0;
+                        }
+                    }
+                }
+                double lookupNs = millisSince(start) * 1e6 / (double(testWords) * LOOKUP_ROUNDS);
+                std::cout << scale << ",vocabulary," << vocabulary->size() << "," << bytes << ","
+                          << buildMs << "," << lookupNs << std::endl;
+                if (sink == -1) std::cerr << sink;
+                delete vocabulary;
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
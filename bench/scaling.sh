@@ -0,0 +1,126 @@
+#!/bin/sh
+# Scaling benchmark: throughput and peak RSS of train, predict and evaluate
+# against data size and thread count, on synthetic data from generate_dataset.
+#
+# Usage: bench/scaling.sh [-b BUILD_DIR] [-r "ROWS..."] [-t "THREADS..."] [-o OUT_DIR] [-k]
+#   -b  Build directory with sentiment and generate_dataset (default: build);
+#       configure it with -DCMAKE_BUILD_TYPE=Release before comparing numbers
+#   -r  Training set sizes in rows (default: "1000000 3000000 10000000");
+#       each test set has half as many rows
+#   -t  Thread counts (default: "1 2 4")
+#   -o  Output directory (default: scaling); needs room for the data, about
+#       135 bytes per row
+#   -k  Keep the generated datasets
+#
+# Each size is generated once (seeded from data/train_dataset_20k.csv) and
+# every command runs once per thread count with --stats. Results go to
+# OUT_DIR/scaling.csv, one row per command, size and thread count, where
+# rows are those the command read (training rows for train, test rows else):
+#
+#   command,rows,threads,seconds,tweets_per_s,mb_per_s,peak_rss_mb,model_words
+#
+# If gnuplot is installed, OUT_DIR/scaling.png plots throughput and peak RSS
+# against rows, one line per command and thread count; otherwise the CSV is
+# printed.
+
+set -e
+
+build=build
+sizes="1000000 3000000 10000000"
+threads="1 2 4"
+out=scaling
+keep=0
+while getopts "b:r:t:o:k" option; do
+    case $option in
+        b) build=$OPTARG ;;
+        r) sizes=$OPTARG ;;
+        t) threads=$OPTARG ;;
+        o) out=$OPTARG ;;
+        k) keep=1 ;;
+        *) sed -n 5p "$0" >&2; exit 1 ;;
+    esac
+done
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+sentiment=$build/sentiment
+generate=$build/generate_dataset
+for tool in "$sentiment" "$generate"; do
+    if [ ! -x "$tool" ]; then
+        echo "Missing $tool; build the project first (-b sets the build directory)" >&2
+        exit 1
+    fi
+done
+mkdir -p "$out"
+results=$out/scaling.csv
+echo "command,rows,threads,seconds,tweets_per_s,mb_per_s,peak_rss_mb,model_words" > "$results"
+
+# Prints field $2 of phase $1 in the --stats file $3 (0 if absent)
+phase_field() {
+    value=$(grep "\"name\": \"$1\"" "$3" | sed -n "s/.*\"$2\": \([0-9.e+-]*\).*/\1/p")
+    echo "${value:-0}"
+}
+
+# Appends the result row of command $1 at $2 rows and $3 threads from stats file $4
+record() {
+    ms=$(phase_field "$1" wall_ms "$4")
+    rss=$(sed -n 's/.*"peak_rss_bytes": \([0-9]*\).*/\1/p' "$4")
+    words=$(sed -n 's/.*"vocabulary": {"words": \([0-9]*\).*/\1/p' "$4")
+    echo "$1,$2,$3,$(awk "BEGIN { print $ms / 1000 }"),$(phase_field "$1" tweets_per_s "$4"),\
+$(phase_field "$1" mb_per_s "$4"),$(awk "BEGIN { printf \"%.1f\", $rss / 1048576 }"),$words" >> "$results"
+}
+
+for rows in $sizes; do
+    testRows=$((rows / 2))
+    train=$out/train_$rows.csv
+    test=$out/test_$rows.csv
+    truth=$out/truth_$rows.csv
+    echo "Generating $rows training and $testRows test rows..." >&2
+    "$generate" "$root/data/train_dataset_20k.csv" train "$rows" "$train" 2> /dev/null
+    "$generate" "$root/data/train_dataset_20k.csv" test "$testRows" "$test" "$truth" 2> /dev/null
+    for n in $threads; do
+        echo "  $n thread(s)" >&2
+        stats=$out/stats.json
+        "$sentiment" train --threads "$n" --stats "$stats" "$train" "$out/model.bin" > /dev/null
+        record train "$rows" "$n" "$stats"
+        "$sentiment" predict --threads "$n" --stats "$stats" "$out/model.bin" "$test" "$out/predictions.csv" \
+            > /dev/null
+        record predict "$testRows" "$n" "$stats"
+        "$sentiment" evaluate --threads "$n" --stats "$stats" "$truth" "$out/predictions.csv" "$out/accuracy.txt" \
+            > /dev/null
+        record evaluate "$testRows" "$n" "$stats"
+    done
+    rm -f "$out/model.bin" "$out/predictions.csv" "$out/accuracy.txt" "$out/stats.json"
+    if [ "$keep" -eq 0 ]; then
+        rm -f "$train" "$test" "$truth"
+    fi
+done
+
+if command -v gnuplot > /dev/null; then
+    plots=""
+    rss=""
+    for command in train predict evaluate; do
+        for n in $threads; do
+            data="\"< grep '^$command,[^,]*,$n,' $results\""
+            plots="$plots${plots:+, }$data using 2:5 with linespoints title '$command, $n thread(s)'"
+            rss="$rss${rss:+, }$data using 2:7 with linespoints title '$command, $n thread(s)'"
+        done
+    done
+    gnuplot <<EOF
+set datafile separator ','
+set terminal png size 1200,500
+set output '$out/scaling.png'
+set multiplot layout 1,2
+set logscale x
+set xlabel 'rows'
+set key left top
+set ylabel 'tweets/s'
+plot $plots
+set ylabel 'peak RSS (MiB)'
+plot $rss
+unset multiplot
+EOF
+    echo "Wrote $results and $out/scaling.png" >&2
+else
+    column -s, -t < "$results" 2> /dev/null || cat "$results"
+    echo "Wrote $results (install gnuplot for scaling.png)" >&2
+fi
@@ -0,0 +1,103 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include "DSString.h"
+#include <cstddef>
+#include <vector>
+
+// Bump allocator for short-lived temporaries, such as everything built while
+// processing one tweet or one batch. Allocation advances a pointer; nothing is
+// freed individually, and reset() forgets every allocation in O(1). Blocks are
+// kept across resets, so once an arena has seen its largest tweet it never
+// calls malloc again.
+// Not thread-safe: use one arena per thread.
+class Arena : public DSStringAllocator {
+public:
+    static constexpr size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    explicit Arena(size_t blockSize = DEFAULT_BLOCK_SIZE);
+    ~Arena() override;
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Uninitialized storage for bytes, aligned to alignment (a power of two)
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // Invalidates everything allocated so far; keeps the blocks
+    void reset();
+
+    size_t bytesUsed() const;      // Handed out since the last reset
+    size_t bytesReserved() const;  // Held in blocks
+    size_t blockCount() const { return blocks.size(); }
+
+    // DSStringAllocator: strings are freed with the arena, not one by one
+    char* allocateChars(size_t bytes) override { return static_cast<char*>(allocate(bytes, 1)); }
+    void deallocateChars(char*, size_t) override {}
+
+private:
+    struct Block {
+        char* data;
+        size_t size;
+    };
+
+    // Moves to the next kept block that fits bytes, adding one if none does
+    void nextBlock(size_t bytes, size_t alignment);
+
+    size_t blockSize;
+    std::vector<Block> blocks;
+    size_t current = 0;    // Index of the block being filled
+    size_t usedBefore = 0; // Bytes handed out from blocks before current
+    char* cursor = nullptr;
+    char* limit = nullptr;
+};
+
+// Standard allocator over an Arena, for containers of per-tweet temporaries:
+//   std::vector<DSStringView, ArenaAllocator<DSStringView>> tokens(arena);
+// deallocate() is a no-op; the memory comes back when the arena is reset.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator(Arena& arena) : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) { return arena->allocateArray<T>(count); }
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+private:
+    template <typename U> friend class ArenaAllocator;
+    Arena* arena;
+};
+
+// Makes arena the DSString allocator of this thread for the scope's lifetime,
+// then resets it. Strings created inside the scope must not outlive it.
+//   for (each tweet) { ArenaScope scope(arena); ...process the tweet... }
+class ArenaScope {
+public:
+    explicit ArenaScope(Arena& arena) : arena(arena), previous(DSString::setAllocator(&arena)) {}
+    ~ArenaScope() {
+        DSString::setAllocator(previous);
+        arena.reset();
+    }
+
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    Arena& arena;
+    DSStringAllocator* previous;
+};
+
+#endif
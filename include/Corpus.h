@@ -0,0 +1,152 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include "CsvReader.h"
+#include "DSString.h"
+#include <cstdint>
+#include <optional>
+#include <string>
+
+// Pre-tokenized corpus: a training or test CSV compiled once into token-id
+// arrays, so repeated runs map it and skip CSV parsing and tokenization.
+//
+// Each tweet keeps its id, its label (training corpora) and the tokens that
+// can affect training or scoring, as produced by the Tokenizer. Normalized
+// words are interned into a dictionary in first-seen order, which is also
+// the order training adds them to a model, so a model trained from a corpus
+// is byte-identical to one trained from its CSV.
+//
+// Layout: a fixed header followed by raw arrays, each starting on a 64-byte
+// boundary, in host byte order (like ModelFile). The header records the
+// source CSV's path, size, modification time and content hash, and a
+// fingerprint of the lexicon, so a corpus that no longer matches its source
+// or this build is detected rather than used.
+enum class CorpusKind : uint32_t {
+    Training = 1,  // sentiment, id, date, query, user, text
+    Test = 2       // id, date, query, user, text
+};
+
+struct CorpusHeader {
+    char magic[8];             // "SNTCORPS"
+    uint32_t version;          // CORPUS_FORMAT_VERSION
+    uint32_t byteOrder;        // MODEL_BYTE_ORDER as written by the host
+    uint64_t fileSize;
+    uint32_t kind;             // CorpusKind
+    uint32_t reserved;
+    uint64_t lexiconHash;      // lexiconFingerprint() of the compiling build
+
+    // Source CSV when the corpus was compiled
+    uint64_t sourceSize;
+    int64_t sourceMtimeNs;
+    uint64_t sourceHash;       // hashCharacters over the whole file
+    uint64_t sourcePathOffset; // Absolute path, not terminated
+    uint64_t sourcePathBytes;
+
+    uint64_t numTweets;
+    uint64_t tweetTokensOffset;  // numTweets + 1 uint64_t: tweet t owns tokens [v[t], v[t + 1])
+    uint64_t labelsOffset;       // numTweets uint8_t (0 or 4); training corpora only
+    uint64_t idOffsetsOffset;    // numTweets + 1 uint64_t into the id arena
+    uint64_t idArenaOffset;
+    uint64_t idArenaBytes;
+
+    uint64_t numTokens;
+    uint64_t tokensOffset;       // numTokens CorpusToken
+
+    uint64_t numWords;
+    uint64_t wordOffsetsOffset;  // numWords uint32_t into the word arena
+    uint64_t wordLengthsOffset;  // numWords uint32_t
+    uint64_t wordInfoOffset;     // numWords CorpusWord
+    uint64_t wordArenaOffset;
+    uint64_t wordArenaBytes;
+};
+
+// One stored token; the Token fields training and scoring read
+struct CorpusToken {
+    uint32_t word;      // Dictionary id of the normalized word, or CORPUS_NO_WORD
+    uint16_t rawFlags;  // Lexicon flags of the raw token, lowercased
+    uint8_t marks;      // TokenMark bits
+    uint8_t reserved;
+};
+
+// Lexicon data of a dictionary word
+struct CorpusWord {
+    uint16_t flags;       // Lexicon flags of the word
+    uint8_t trainWeight;  // Lexicon training weight (1 if none)
+    uint8_t reserved;
+};
+
+const uint32_t CORPUS_FORMAT_VERSION = 1;
+const uint32_t CORPUS_NO_WORD = UINT32_MAX;
+
+// Sizes of a compiled corpus
+struct CorpusSummary {
+    CorpusKind kind;
+    uint64_t tweets;
+    uint64_t tokens;
+    uint64_t words;
+    uint64_t bytes;
+};
+
+// Compiles the CSV at csvPath into a corpus at corpusPath. The kind is taken
+// from the header row (six columns: training, five: test). The file is
+// written under a temporary name and renamed over corpusPath.
+// Throws std::runtime_error on I/O failure or an unrecognized header.
+CorpusSummary compileCorpus(const char* csvPath, const char* corpusPath);
+
+// Hash of the lexicon and tokenizer rules a corpus was compiled with
+uint64_t lexiconFingerprint();
+
+// True if a mapped file starts with the corpus magic
+bool isCorpusFile(const MappedFile& file);
+
+// Read-only view of a mapped corpus; the mapping must outlive it
+class Corpus {
+public:
+    // Validates the header and, in one pass, the tweet extents, token word ids
+    // and word extents; throws std::runtime_error if the file is not a corpus
+    // this build can read
+    explicit Corpus(const MappedFile& file);
+
+    CorpusKind kind() const { return static_cast<CorpusKind>(header.kind); }
+    size_t size() const { return header.numTweets; }
+    size_t numTokens() const { return header.numTokens; }
+    size_t numWords() const { return header.numWords; }
+
+    DSStringView id(size_t tweet) const {
+        return DSStringView(idArena + idOffsets[tweet], idOffsets[tweet + 1] - idOffsets[tweet]);
+    }
+    // 0 or 4; training corpora only
+    int label(size_t tweet) const { return labels[tweet]; }
+    const CorpusToken* tokensBegin(size_t tweet) const { return tokens + tweetTokens[tweet]; }
+    const CorpusToken* tokensEnd(size_t tweet) const { return tokens + tweetTokens[tweet + 1]; }
+
+    DSStringView word(uint32_t id) const { return DSStringView(wordArena + wordOffsets[id], wordLengths[id]); }
+    const CorpusWord& wordInfo(uint32_t id) const { return wordInfos[id]; }
+
+    std::string sourcePath() const { return std::string(base + header.sourcePathOffset, header.sourcePathBytes); }
+    // True if this build's lexicon differs from the compiling one, or the
+    // source CSV exists and has changed (size, or content when only the
+    // modification time differs). A missing source is not stale.
+    bool isStale() const;
+
+private:
+    CorpusHeader header;
+    const char* base;
+    const uint64_t* tweetTokens;
+    const uint8_t* labels;
+    const uint64_t* idOffsets;
+    const char* idArena;
+    const CorpusToken* tokens;
+    const uint32_t* wordOffsets;
+    const uint32_t* wordLengths;
+    const CorpusWord* wordInfos;
+    const char* wordArena;
+};
+
+// Maps path, which may name a CSV or a corpus. A corpus that is stale (see
+// Corpus::isStale) is replaced by its source CSV, with a warning on stderr.
+// Returns the validated corpus if file holds one, so callers do not validate
+// it again; file is left closed if nothing could be opened.
+std::optional<Corpus> openCorpusOrCsv(const char* path, MappedFile& file);
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef COUNT_MIN_SKETCH_H
+#define COUNT_MIN_SKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Count-min sketch over 64-bit item hashes: DEPTH rows of 2^bits counters.
+// add() bumps one counter per row and estimate() returns the smallest, which
+// never undercounts and, with probability 1 - e^-DEPTH, overcounts by at most
+// e * totalCount() / 2^bits. Memory is fixed by bits, however many distinct
+// items are added. The sketch is linear, so per-thread sketches of the same
+// shape merge exactly into the sketch a serial pass would build.
+//
+// It answers "was this seen at least n times" for small n, so counters are
+// one byte and saturate at MAX_COUNT: for the same memory that gives four
+// times the width of 32-bit counters, and width is what keeps the many
+// one-off items from pushing each other over the threshold.
+class CountMinSketch {
+public:
+    static constexpr unsigned DEPTH = 4;
+    static constexpr unsigned MIN_BITS = 10;
+    static constexpr unsigned MAX_BITS = 30;
+    static constexpr uint32_t MAX_COUNT = UINT8_MAX;
+
+    // Throws std::runtime_error for bits outside [MIN_BITS, MAX_BITS]
+    explicit CountMinSketch(unsigned bits);
+
+    // hash should be well mixed in all 64 bits (e.g. Vocabulary::hashWord)
+    void add(uint64_t hash, uint32_t count = 1) {
+        for (unsigned row = 0; row < DEPTH; row++) {
+            uint8_t& counter = counters[index(hash, row)];
+            counter = static_cast<uint8_t>(count >= MAX_COUNT - counter ? MAX_COUNT : counter + count);
+        }
+        total += count;
+    }
+    // Upper bound on the count of hash, capped at MAX_COUNT
+    uint32_t estimate(uint64_t hash) const {
+        uint32_t smallest = MAX_COUNT;
+        for (unsigned row = 0; row < DEPTH; row++) {
+            uint32_t counter = counters[index(hash, row)];
+            smallest = counter < smallest ? counter : smallest;
+        }
+        return smallest;
+    }
+    // Adds other, which must have the same bits
+    void merge(const CountMinSketch& other);
+
+    unsigned bits() const { return numBits; }
+    uint64_t totalCount() const { return total; }
+    size_t memoryUsage() const { return counters.capacity(); }
+
+private:
+    // Row r probes h1 + r * h2 (double hashing on the two 32-bit halves)
+    size_t index(uint64_t hash, unsigned row) const {
+        uint32_t h1 = static_cast<uint32_t>(hash);
+        uint32_t h2 = static_cast<uint32_t>(hash >> 32) | 1;
+        return (static_cast<size_t>(row) << numBits) + ((h1 + row * h2) & mask);
+    }
+
+    std::vector<uint8_t> counters;  // Row-major, DEPTH * 2^bits
+    unsigned numBits;
+    uint32_t mask;
+    uint64_t total = 0;
+};
+
+#endif
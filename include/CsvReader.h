@@ -0,0 +1,84 @@
+#ifndef CSV_READER_H
+#define CSV_READER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Non-owning view of a run of characters inside a mapped file.
+// Valid only while the MappedFile it came from is alive.
+struct CsvField {
+    const char* data = nullptr;
+    size_t length = 0;
+
+    bool empty() const { return length == 0; }
+    char front() const { return data[0]; }
+    char back() const { return data[length - 1]; }
+    bool equals(const char* str) const;
+    std::string str() const { return std::string(data, length); }
+
+    // Drops surrounding characters from " \t\r\n"
+    CsvField trimmed() const;
+    // Drops one leading and one trailing double quote, if present
+    CsvField unquoted() const;
+};
+
+// Read-only memory mapping of a whole file (POSIX mmap)
+// Pages are shared through the page cache with every other process mapping the same file.
+class MappedFile {
+private:
+    const char* mapData = nullptr;
+    size_t mapSize = 0;
+    bool isOpen = false;
+
+public:
+    MappedFile() = default;
+    explicit MappedFile(const char* path, bool sequential = true) { open(path, sequential); }
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Maps the file, returning false if it cannot be opened.
+    // sequential hints front-to-back reading; pass false for random access.
+    bool open(const char* path, bool sequential = true);
+    void close();
+
+    bool is_open() const { return isOpen; }
+    const char* data() const { return mapData; }
+    size_t size() const { return mapSize; }
+
+    // Hints that bytes [begin, end) will not be read again: the whole pages in
+    // the range leave this process's resident set (the page cache keeps them,
+    // and a later read faults them back in). Returns end rounded down to a page
+    // boundary (but not below begin); passing it back as the next begin lets a front-to-back pass
+    // over a file larger than RAM run in bounded memory.
+    size_t dropPages(size_t begin, size_t end) const;
+};
+
+// Walks the lines of a byte range of a mapped file without copying them.
+// Fields are split the same way the old getline(ss, field, ',') code did:
+// the first maxFields - 1 fields end at a comma, the last takes the rest of the line.
+class CsvReader {
+private:
+    const char* cursor;
+    const char* end;
+
+public:
+    explicit CsvReader(const MappedFile& file);
+    CsvReader(const char* begin, const char* end) : cursor(begin), end(end) {}
+
+    // Returns the next line without its '\n'; false at the end of the range
+    bool nextLine(CsvField& line);
+    // Offset of the next unread byte, relative to base
+    size_t position(const char* base) const { return static_cast<size_t>(cursor - base); }
+
+    // Fills out[0..maxFields); missing trailing fields are left empty
+    static void splitFields(const CsvField& line, CsvField* out, size_t maxFields);
+
+    // Splits [begin, end) into parts byte ranges that start on line starts.
+    // Returns parts + 1 bounds; range i is [bounds[i], bounds[i + 1]) and may be empty.
+    static std::vector<const char*> splitLines(const char* begin, const char* end, size_t parts);
+};
+
+#endif
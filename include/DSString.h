@@ -1,21 +1,83 @@
 #ifndef DSSTRING_H
 #define DSSTRING_H
 
+#include <atomic>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 
+/**
+ * @class DSStringAllocator
+ * @brief Source of heap buffers for DSString
+ *
+ * Install one for the current thread with DSString::setAllocator(); every
+ * DSString that outgrows its inline buffer on that thread then takes its
+ * characters from it. Each string remembers the allocator it used, so it is
+ * returned to the right one even after the thread switches allocators.
+ */
+class DSStringAllocator {
+public:
+    virtual ~DSStringAllocator() = default;
+
+    /**
+     * @brief Returns storage for bytes characters
+     */
+    virtual char* allocateChars(size_t bytes) = 0;
+
+    /**
+     * @brief Returns storage obtained from allocateChars
+     * @param ptr Buffer to release
+     * @param bytes Size it was requested with
+     */
+    virtual void deallocateChars(char* ptr, size_t bytes) = 0;
+};
+
 /**
  * @class DSString
  * @brief Custom string class implementation with dynamic memory management
  * 
  * This class provides basic string operations while managing its own memory.
- * Implements the Rule of Three: destructor, copy constructor, and copy assignment.
+ * Implements the Rule of Five: destructor, copy/move constructors, and copy/move assignment.
+ * Strings of up to SSO_CAPACITY characters are stored inline in the object
+ * (small-string optimization), so most tokens never touch the heap.
+ * Longer strings use operator new, or the thread's DSStringAllocator if set.
+ * The hash of the contents is computed on first use and cached until the
+ * string is modified.
  */
 class DSString {
+public:
+    static constexpr size_t SSO_CAPACITY = 15;  // Longest string stored inline
+
 private:
-    char* data;      // Pointer to the dynamically allocated character array
+    char* data;      // Points to inlineBuffer or to a heap-allocated character array
     size_t length;   // Length of the string (excluding null terminator)
+    // Characters of an inline string; for a heap string, the allocator that owns data
+    char inlineBuffer[SSO_CAPACITY + 1];
+    // Cached hash(), or 0 if not computed since the last change
+    mutable std::atomic<size_t> cachedHash{0};
+
+    // Allocator for new heap buffers on this thread (nullptr = operator new)
+    static thread_local DSStringAllocator* threadAllocator;
+
+    bool isInline() const { return data == inlineBuffer; }
+    DSStringAllocator* owner() const;
+    void setOwner(DSStringAllocator* allocator);
+    // Points data at storage for len characters plus terminator; sets length
+    void allocate(size_t len);
+    // Frees heap storage, if any
+    void release();
+    // Copies the cached hash of str, whose contents this string now holds
+    void takeHash(const DSString& str);
 
 public:
+    /**
+     * @brief Sets the allocator for heap buffers created on this thread
+     * @param allocator New allocator, or nullptr for operator new
+     * @return The previous allocator
+     * Strings from an allocator must be destroyed before it frees its memory.
+     */
+    static DSStringAllocator* setAllocator(DSStringAllocator* allocator);
+
     /**
      * @brief Default constructor creates an empty string
      * Time Complexity: O(1)
@@ -29,6 +91,14 @@ public:
      */
     DSString(const char* str);
 
+    /**
+     * @brief Constructor from a character buffer of known length
+     * @param str Characters to copy (need not be null-terminated)
+     * @param len Number of characters to copy
+     * Time Complexity: O(n) where n is len
+     */
+    DSString(const char* str, size_t len);
+
     /**
      * @brief Copy constructor
      * @param str DSString to copy from
@@ -36,6 +106,13 @@ public:
      */
     DSString(const DSString& str);
 
+    /**
+     * @brief Move constructor
+     * @param str DSString to take the contents of; left empty afterwards
+     * Time Complexity: O(1)
+     */
+    DSString(DSString&& str) noexcept;
+
     /**
      * @brief Destructor to free allocated memory
      * Time Complexity: O(1)
@@ -50,6 +127,14 @@ public:
      */
     DSString& operator=(const DSString& str);
 
+    /**
+     * @brief Move assignment operator
+     * @param str DSString to take the contents of; left empty afterwards
+     * @return Reference to this object
+     * Time Complexity: O(1)
+     */
+    DSString& operator=(DSString&& str) noexcept;
+
     /**
      * @brief String concatenation operator
      * @param str String to append
@@ -88,6 +173,7 @@ public:
      * @return Reference to character at position
      * Time Complexity: O(1)
      * @throws std::out_of_range if index is invalid
+     * The non-const form drops the cached hash, since the character may change.
      */
     char& operator[](size_t index);
     const char& operator[](size_t index) const;
@@ -99,6 +185,14 @@ public:
      */
     size_t getLength() const;
 
+    /**
+     * @brief Hash of the contents, equal to that of an equal DSStringView
+     * @return hashCharacters(c_str(), getLength())
+     * Time Complexity: O(n) on the first call, O(1) while the string is unchanged
+     * Safe to call from several threads at once.
+     */
+    size_t hash() const;
+
     /**
      * @brief Get underlying C-string
      * @return Pointer to null-terminated character array
@@ -125,25 +219,206 @@ public:
     friend std::ostream& operator<<(std::ostream& out, const DSString& str);
 };
 
+/**
+ * @class DSStringView
+ * @brief Non-owning, read-only view of a character range (pointer + length)
+ * 
+ * Used for tokens that point into a larger buffer such as a tweet or a mapped
+ * file. The viewed characters must outlive the view and are not required to be
+ * null-terminated. A DSString converts implicitly, so views compare against
+ * DSStrings directly and hash to the same value as an equal DSString.
+ */
+class DSStringView {
+private:
+    const char* ptr;  // First viewed character
+    size_t length;    // Number of viewed characters
+
+public:
+    /**
+     * @brief Default constructor creates an empty view
+     * Time Complexity: O(1)
+     */
+    DSStringView() : ptr(""), length(0) {}
+
+    /**
+     * @brief Views len characters starting at str
+     * Time Complexity: O(1)
+     */
+    DSStringView(const char* str, size_t len) : ptr(str), length(len) {}
+
+    /**
+     * @brief Views a null-terminated C-string (excluding the terminator)
+     * Time Complexity: O(n) where n is string length
+     */
+    DSStringView(const char* str);
+
+    /**
+     * @brief Views the contents of a DSString
+     * Time Complexity: O(1)
+     */
+    DSStringView(const DSString& str) : ptr(str.c_str()), length(str.getLength()) {}
+
+    size_t getLength() const { return length; }
+    bool empty() const { return length == 0; }
+    const char* data() const { return ptr; }
+
+    /**
+     * @brief Unchecked character access
+     * @param index Position to access; must be less than getLength()
+     */
+    char operator[](size_t index) const { return ptr[index]; }
+
+    /**
+     * @brief View of a sub-range, clamped to the end of this view
+     * Time Complexity: O(1)
+     */
+    DSStringView substring(size_t start, size_t numChars) const;
+
+    /**
+     * @brief Checks whether the view contains a character or character sequence
+     * Time Complexity: O(n * m) where m is the needle length
+     */
+    bool contains(char c) const;
+    bool contains(DSStringView needle) const;
+
+    /**
+     * @brief Content equality (also against DSString and C-strings via conversion)
+     * Time Complexity: O(n) where n is string length
+     */
+    bool operator==(DSStringView other) const;
+    bool operator!=(DSStringView other) const { return !(*this == other); }
+
+    /**
+     * @brief Copies the viewed characters into an owning DSString
+     * Time Complexity: O(n) where n is string length
+     */
+    DSString toString() const { return DSString(ptr, length); }
+
+    friend std::ostream& operator<<(std::ostream& out, DSStringView str);
+};
+
+namespace hashing {
+    // Mixing constants (the wyhash secret)
+    const uint64_t SECRET0 = 0xa0761d6478bd642fULL;
+    const uint64_t SECRET1 = 0xe7037ed1a0b428dbULL;
+    const uint64_t SECRET2 = 0x8ebc6af09c88c6e3ULL;
+
+    /**
+     * @brief 64x64 -> 128-bit multiply
+     * @param a Set to the low half of the product
+     * @param b Set to the high half of the product
+     */
+    inline void multiply(uint64_t& a, uint64_t& b) {
+#if defined(__SIZEOF_INT128__)
+        __extension__ typedef unsigned __int128 uint128;
+        uint128 product = static_cast<uint128>(a) * b;
+        a = static_cast<uint64_t>(product);
+        b = static_cast<uint64_t>(product >> 64);
+#else
+        uint64_t aHigh = a >> 32, aLow = static_cast<uint32_t>(a);
+        uint64_t bHigh = b >> 32, bLow = static_cast<uint32_t>(b);
+        uint64_t high = aHigh * bHigh, mid0 = aHigh * bLow, mid1 = bHigh * aLow, low = aLow * bLow;
+        uint64_t t = low + (mid0 << 32);
+        uint64_t carry = t < low;
+        uint64_t lowSum = t + (mid1 << 32);
+        carry += lowSum < t;
+        b = high + (mid0 >> 32) + (mid1 >> 32) + carry;
+        a = lowSum;
+#endif
+    }
+
+    // Both halves of a * b folded into 64 bits
+    inline uint64_t mix(uint64_t a, uint64_t b) {
+        multiply(a, b);
+        return a ^ b;
+    }
+
+    inline uint64_t read8(const char* p) {
+        uint64_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint64_t read4(const char* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return v;
+    }
+
+    inline uint64_t byte(const char* p) {
+        return static_cast<unsigned char>(*p);
+    }
+}
+
+/**
+ * @brief Word-at-a-time hash over a character range (wyhash construction)
+ * Shared by the DSString and DSStringView hashers so equal contents hash equally.
+ * Uses the known length instead of scanning for a terminator: up to 16 bytes
+ * are read as at most four overlapping loads, longer ranges 16 bytes per
+ * step, and the result goes through a full 128-bit multiply, so every output
+ * bit (including the low bits used for bucketing) depends on every input bit.
+ * Time Complexity: O(n) where n is len
+ */
+inline uint64_t hashCharacters(const char* ptr, size_t len) {
+    using namespace hashing;
+    uint64_t seed = SECRET2 ^ mix(SECRET2 ^ SECRET0, SECRET1);
+    uint64_t a, b;
+    if (len <= 16) {
+        if (len >= 4) {
+            size_t shift = (len >> 3) << 2;  // 4 when len >= 8, so the loads cover all bytes
+            a = (read4(ptr) << 32) | read4(ptr + shift);
+            b = (read4(ptr + len - 4) << 32) | read4(ptr + len - 4 - shift);
+        } else if (len > 0) {
+            a = (byte(ptr) << 16) | (byte(ptr + (len >> 1)) << 8) | byte(ptr + len - 1);
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t remaining = len;
+        while (remaining > 16) {
+            seed = mix(read8(ptr) ^ SECRET1, read8(ptr + 8) ^ seed);
+            ptr += 16;
+            remaining -= 16;
+        }
+        a = read8(ptr + remaining - 16);
+        b = read8(ptr + remaining - 8);
+    }
+    a ^= SECRET1;
+    b ^= seed;
+    multiply(a, b);
+    return mix(a ^ SECRET0 ^ len, b ^ SECRET1);
+}
+
+inline size_t DSString::hash() const {
+    size_t value = cachedHash.load(std::memory_order_relaxed);
+    if (value == 0) {
+        value = static_cast<size_t>(hashCharacters(data, length));
+        cachedHash.store(value, std::memory_order_relaxed);
+    }
+    return value;
+}
+
 /**
  * @brief Hash function specialization for DSString
  * 
- * Implements DJB2 hash algorithm for use in unordered containers
- * Time Complexity: O(n) where n is string length
+ * Uses the string's cached hash for unordered containers
+ * Time Complexity: O(n) where n is string length, O(1) once cached
  */
 namespace std {
     template <>
     struct hash<DSString> {
         size_t operator()(const DSString& str) const {
-            size_t hash = 5381;
-            const char* ptr = str.c_str();
-            while (*ptr) {
-                hash = ((hash << 5) + hash) + (*ptr); // hash * 33 + c
-                ptr++;
-            }
-            return hash;
+            return str.hash();
+        }
+    };
+
+    template <>
+    struct hash<DSStringView> {
+        size_t operator()(DSStringView str) const {
+            return static_cast<size_t>(hashCharacters(str.data(), str.getLength()));
         }
     };
 }
 
-#endif 
\ No newline at end of file
+#endif
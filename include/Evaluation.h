@@ -0,0 +1,50 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include "CsvReader.h"
+#include "ThreadPool.h"
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// Outcome of comparing a predictions file with the ground truth
+struct EvaluationResult {
+    static constexpr int NUM_LABELS = 5;  // Sentiment values 0..4
+
+    // A misclassified tweet; id points into the mapped truth file
+    struct Error {
+        CsvField id;
+        int predicted;
+        int actual;
+    };
+
+    uint64_t confusion[NUM_LABELS][NUM_LABELS] = {};  // [actual][predicted]
+    uint64_t total = 0;    // Truth rows paired with a prediction
+    uint64_t correct = 0;
+    uint64_t missing = 0;  // Truth rows without a prediction for their id
+    std::vector<Error> errors;  // In truth-file order
+
+    double accuracy() const;
+    // Label occurs as an actual or a predicted value
+    bool hasLabel(int label) const;
+    // Per-label metrics, treating label as the positive class (0 when undefined)
+    double precision(int label) const;
+    double recall(int label) const;
+    double f1(int label) const;
+};
+
+// Joins the truth file ("Sentiment,id" header, then sentiment,id rows) with a
+// predictions file (sentiment,id rows, any order) by tweet id. The k-th truth
+// row with a given id is paired with the k-th prediction for that id, so two
+// files in the same order pair line by line even where ids repeat.
+// Both files are parsed in parallel chunks; the join is partitioned by id
+// hash so each worker builds and probes its own table without locks.
+// Throws std::runtime_error on a malformed row.
+EvaluationResult evaluate(const MappedFile& truth, const MappedFile& predictions, ThreadPool& pool);
+
+// Writes the accuracy file: the accuracy with 3 decimals, one
+// "predicted,actual,id" line per misclassified tweet, then the metrics
+// (counts, confusion matrix, precision/recall/F1) on lines starting with "# "
+void writeAccuracyReport(const EvaluationResult& result, std::ostream& out);
+
+#endif
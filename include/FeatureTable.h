@@ -0,0 +1,75 @@
+#ifndef FEATURE_TABLE_H
+#define FEATURE_TABLE_H
+
+#include "Vocabulary.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Hashed feature counts (the "hashing trick"): a fixed power-of-two array of
+// {pos, neg} counters addressed by the low bits of a feature's hash. Unigram
+// and bigram features share the array and are never stored as keys, so
+// counting allocates nothing and the table takes 8 * 2^bits bytes however
+// many distinct features the data holds. Features whose hashes collide in
+// the low bits share a counter.
+//
+// Like Vocabulary, the counters are read through a view that points either
+// at owned storage or at an attached read-only buffer (a mapped model file);
+// the first mutation of an attached table copies it.
+class FeatureTable {
+public:
+    static constexpr unsigned MIN_BITS = 10;
+    static constexpr unsigned MAX_BITS = 30;
+
+    // bits = 0 is an empty, disabled table
+    explicit FeatureTable(unsigned bits = 0) { reset(bits); }
+    FeatureTable(const FeatureTable& other);
+    FeatureTable& operator=(const FeatureTable& other);
+
+    // Replaces the contents with 2^bits zero counters (none for bits = 0);
+    // throws std::runtime_error if bits is outside [MIN_BITS, MAX_BITS]
+    void reset(unsigned bits);
+
+    bool enabled() const { return numBits > 0; }
+    unsigned bits() const { return numBits; }
+    size_t size() const { return numBits > 0 ? mask + 1 : 0; }
+
+    // Feature hashes; wordHash is Vocabulary::hashWord of a normalized word
+    static uint64_t unigram(uint64_t wordHash) { return wordHash; }
+    static uint64_t bigram(uint64_t previousHash, uint64_t wordHash) {
+        return hashing::mix(previousHash ^ hashing::SECRET0, wordHash ^ hashing::SECRET2);
+    }
+
+    const WordCount& counts(uint64_t feature) const { return countView[feature & mask]; }
+    void add(uint64_t feature, int pos, int neg) {
+        if (attached) makeWritable();
+        WordCount& count = owned[feature & mask];
+        count.pos += pos;
+        count.neg += neg;
+    }
+    // Adds other's counters (same size), each multiplied by factor and rounded
+    void add(const FeatureTable& other, double factor = 1.0);
+    // Multiplies every counter by factor, rounding
+    void scale(double factor);
+
+    // Counter array, size() entries
+    const WordCount* data() const { return countView; }
+    // Serves counts straight from external, which must outlive this object
+    // (or the next mutation)
+    void attach(const WordCount* external, unsigned bits);
+    bool isAttached() const { return attached; }
+
+    // Bytes of heap memory held by the counters
+    size_t memoryUsage() const { return owned.capacity() * sizeof(WordCount); }
+
+private:
+    void makeWritable();
+
+    std::vector<WordCount> owned;
+    const WordCount* countView = nullptr;
+    size_t mask = 0;
+    unsigned numBits = 0;
+    bool attached = false;
+};
+
+#endif
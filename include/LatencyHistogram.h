@@ -0,0 +1,43 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+// Fixed-size log-linear histogram of durations in nanoseconds.
+// Each power of two is split into 8 linear sub-buckets, so any reported
+// percentile is within 12.5% of the true value, and recording is O(1)
+// with no allocation. Covers 1 ns to about 2^40 ns (18 minutes).
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BUCKETS = 8;
+    static constexpr int MAX_EXPONENT = 40;
+    static constexpr int NUM_BUCKETS = (MAX_EXPONENT + 1) * SUB_BUCKETS;
+
+    void record(uint64_t nanos);
+    void merge(const LatencyHistogram& other);
+    void clear();
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return largest; }
+    uint64_t totalNanos() const { return sum; }
+    double mean() const { return total ? static_cast<double>(sum) / total : 0.0; }
+
+    // Upper bound of the bucket holding the q-th quantile (q in [0, 1]); 0 if empty
+    uint64_t percentile(double q) const;
+
+    // Writes {"count":..,"mean_ns":..,"p50_ns":..,"p90_ns":..,"p99_ns":..,"max_ns":..}
+    void writeJson(std::ostream& out) const;
+
+private:
+    static int bucketOf(uint64_t nanos);
+    static uint64_t bucketUpperBound(int bucket);
+
+    std::array<uint64_t, NUM_BUCKETS> buckets{};
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t largest = 0;
+};
+
+#endif
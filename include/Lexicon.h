@@ -0,0 +1,234 @@
+#ifndef LEXICON_H
+#define LEXICON_H
+
+#include "DSString.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed word lists used by training and scoring, compiled into a single
+// perfect-hash table. Every listed word owns exactly one slot, so a lookup is
+// one hash, one table read and one string compare, and it returns all of the
+// word's roles at once. The table and its hash seed are computed by the
+// compiler; a collision in the word lists fails the build, not a run.
+
+// Roles a lexicon word can play
+enum LexiconFlag : uint16_t {
+    LEX_POSITIVE_EMOTICON = 1 << 0,  // Training: weight 4, counted as positive
+    LEX_NEGATIVE_EMOTICON = 1 << 1,  // Training: weight 4, counted as negative
+    LEX_TRAIN_STRONG      = 1 << 2,  // Training: strong sentiment word, weight 3
+    LEX_SCORE_POSITIVE    = 1 << 3,  // Scoring: very strong positive indicator
+    LEX_SCORE_NEGATIVE    = 1 << 4,  // Scoring: very strong negative indicator
+    LEX_NEGATION          = 1 << 5,  // Scoring: flips the next scored word
+    LEX_STOP_WORD         = 1 << 6   // Preprocessing: dropped before counting
+};
+
+// Result of a lexicon lookup
+struct LexiconEntry {
+    const char* text;
+    uint8_t length;
+    uint8_t trainWeight;  // Weight updateWordFrequency gives the word (1 if none)
+    uint16_t flags;
+};
+
+namespace lexicon {
+
+struct WordList {
+    const char* const* words;
+    size_t count;
+    uint16_t flags;
+};
+
+constexpr const char* POSITIVE_EMOTICONS[] = {
+    ":)", ":-)", ":D", "=)", "<3", ";)", ";D", ":-D", "=D"
+};
+constexpr const char* NEGATIVE_EMOTICONS[] = {
+    ":(", ":-(", "=(", ":'(", ":/", ":-/", ":|", ":-|"
+};
+constexpr const char* TRAIN_STRONG_WORDS[] = {
+    "love", "awesome", "excellent", "amazing", "fantastic", "perfect", "wonderful", "great",
+    "hate", "terrible", "awful", "horrible", "worst", "sucks", "disappointed", "bad"
+};
+// Reduced to the most reliable indicators
+constexpr const char* SCORE_POSITIVE_WORDS[] = {
+    "love", "awesome", "amazing", "thank", "thanks", "best"
+};
+constexpr const char* SCORE_NEGATIVE_WORDS[] = {
+    "hate", "terrible", "worst", "sucks", "horrible"
+};
+// Core negation words only
+constexpr const char* NEGATION_WORDS[] = {
+    "not", "no", "never", "don't", "doesn't", "didn't"
+};
+constexpr const char* STOP_WORDS[] = {
+    "the", "be", "to", "of", "and", "a", "in", "that", "have",
+    "i", "it", "for", "on", "with", "he", "as", "you",
+    "do", "at", "this", "but", "his", "by", "from", "they",
+    "we", "say", "her", "she", "or", "an", "will", "my",
+    "all", "would", "there", "their", "what", "so", "up", "out",
+    "if", "about", "who", "get", "which", "go", "me",
+    "when", "make", "can", "like", "time", "just", "him",
+    "take", "people", "into", "year", "your", "some"
+};
+// Never treated as stop words: negations and strong words matter for sentiment
+constexpr const char* KEEP_WORDS[] = {
+    "not", "no", "never", "none", "nothing", "nowhere", "neither",
+    "good", "bad", "great", "terrible", "awesome", "horrible"
+};
+
+template <size_t N>
+constexpr WordList list(const char* const (&words)[N], uint16_t flags) {
+    return WordList{words, N, flags};
+}
+
+constexpr WordList WORD_LISTS[] = {
+    list(POSITIVE_EMOTICONS, LEX_POSITIVE_EMOTICON),
+    list(NEGATIVE_EMOTICONS, LEX_NEGATIVE_EMOTICON),
+    list(TRAIN_STRONG_WORDS, LEX_TRAIN_STRONG),
+    list(SCORE_POSITIVE_WORDS, LEX_SCORE_POSITIVE),
+    list(SCORE_NEGATIVE_WORDS, LEX_SCORE_NEGATIVE),
+    list(NEGATION_WORDS, LEX_NEGATION),
+    list(STOP_WORDS, LEX_STOP_WORD)
+};
+
+constexpr size_t MAX_ENTRIES = 128;
+constexpr size_t TABLE_SIZE = 2048;  // Power of two; sparse enough to find a seed quickly
+
+constexpr size_t length(const char* str) {
+    size_t n = 0;
+    while (str[n] != '\0') n++;
+    return n;
+}
+
+constexpr bool equal(const char* a, size_t aLength, const char* b) {
+    for (size_t i = 0; i < aLength; i++) {
+        if (b[i] != a[i]) return false;
+    }
+    return b[aLength] == '\0';
+}
+
+// FNV-1a with a seed folded into the offset basis
+constexpr uint32_t hash(const char* str, size_t len, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (size_t i = 0; i < len; i++) {
+        h ^= static_cast<uint8_t>(str[i]);
+        h *= 16777619u;
+    }
+    h ^= h >> 15;
+    return h;
+}
+
+struct Table {
+    std::array<LexiconEntry, MAX_ENTRIES> entries{};  // entries[0] is unused
+    size_t numEntries = 1;
+    std::array<uint8_t, TABLE_SIZE> slots{};          // 0 = empty, else entry index
+    uint32_t seed = 0;
+    bool valid = false;
+};
+
+constexpr bool isKeepWord(const char* word) {
+    for (const char* keep : KEEP_WORDS) {
+        if (equal(word, length(word), keep)) return true;
+    }
+    return false;
+}
+
+// Merges the word lists into one entry per distinct word, then searches for
+// a seed under which every entry lands in its own slot
+constexpr Table buildTable() {
+    Table table;
+    for (const WordList& wordList : WORD_LISTS) {
+        for (size_t w = 0; w < wordList.count; w++) {
+            const char* word = wordList.words[w];
+            uint16_t flags = wordList.flags;
+            if ((flags & LEX_STOP_WORD) && isKeepWord(word)) continue;
+
+            size_t index = 1;
+            while (index < table.numEntries &&
+                   !equal(table.entries[index].text, table.entries[index].length, word)) {
+                index++;
+            }
+            if (index == table.numEntries) {
+                table.entries[index] = LexiconEntry{word, static_cast<uint8_t>(length(word)), 1, 0};
+                table.numEntries++;
+            }
+            LexiconEntry& entry = table.entries[index];
+            entry.flags = static_cast<uint16_t>(entry.flags | flags);
+            if (flags & (LEX_POSITIVE_EMOTICON | LEX_NEGATIVE_EMOTICON)) entry.trainWeight = 4;
+            else if ((flags & LEX_TRAIN_STRONG) && entry.trainWeight < 3) entry.trainWeight = 3;
+        }
+    }
+
+    for (uint32_t seed = 0; seed < 10000; seed++) {
+        std::array<uint8_t, TABLE_SIZE> slots{};
+        bool collision = false;
+        for (size_t i = 1; i < table.numEntries && !collision; i++) {
+            const LexiconEntry& entry = table.entries[i];
+            size_t slot = hash(entry.text, entry.length, seed) & (TABLE_SIZE - 1);
+            if (slots[slot] != 0) collision = true;
+            slots[slot] = static_cast<uint8_t>(i);
+        }
+        if (!collision) {
+            table.slots = slots;
+            table.seed = seed;
+            table.valid = true;
+            return table;
+        }
+    }
+    return table;
+}
+
+constexpr Table TABLE = buildTable();
+static_assert(TABLE.valid, "No collision-free seed for the lexicon; enlarge TABLE_SIZE");
+static_assert(TABLE.numEntries <= MAX_ENTRIES, "Lexicon has too many words");
+
+constexpr const LexiconEntry* find(const char* str, size_t len) {
+    const LexiconEntry& entry = TABLE.entries[TABLE.slots[hash(str, len, TABLE.seed) & (TABLE_SIZE - 1)]];
+    if (entry.length != len || entry.text == nullptr) return nullptr;
+    for (size_t i = 0; i < len; i++) {
+        if (entry.text[i] != str[i]) return nullptr;
+    }
+    return &entry;
+}
+
+// Length of the longest lexicon word
+constexpr size_t maxLength() {
+    size_t longest = 0;
+    for (size_t i = 1; i < TABLE.numEntries; i++) {
+        if (TABLE.entries[i].length > longest) longest = TABLE.entries[i].length;
+    }
+    return longest;
+}
+
+constexpr uint16_t flagsOf(const char* str) {
+    const LexiconEntry* entry = find(str, length(str));
+    return entry ? entry->flags : 0;
+}
+
+static_assert(flagsOf("the") == LEX_STOP_WORD, "stop word");
+static_assert(flagsOf("love") == (LEX_TRAIN_STRONG | LEX_SCORE_POSITIVE), "merged roles");
+static_assert(flagsOf("no") == LEX_NEGATION, "keep words are not stop words");
+static_assert(flagsOf(":-D") == LEX_POSITIVE_EMOTICON, "emoticon");
+static_assert(flagsOf("lov") == 0 && flagsOf("") == 0, "exact matches only");
+
+} // namespace lexicon
+
+/**
+ * @brief Looks a word up in the compiled lexicon
+ * @param word Word to classify (exact, case-sensitive match)
+ * @return The word's entry, or nullptr if it is in none of the lists
+ * Time Complexity: O(n) where n is word length (one hash, one compare)
+ */
+inline const LexiconEntry* lookupLexicon(DSStringView word) {
+    return lexicon::find(word.data(), word.getLength());
+}
+
+/**
+ * @brief Flags of a word, or 0 if it is not in the lexicon
+ */
+inline uint16_t lexiconFlags(DSStringView word) {
+    const LexiconEntry* entry = lookupLexicon(word);
+    return entry ? entry->flags : 0;
+}
+
+#endif
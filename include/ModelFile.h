@@ -0,0 +1,66 @@
+#ifndef MODEL_FILE_H
+#define MODEL_FILE_H
+
+#include "Vocabulary.h"
+#include "FeatureTable.h"
+#include "CsvReader.h"
+#include <cstdint>
+
+// Binary model file: a fixed header followed by the raw Vocabulary arrays
+// (hash slots, word offsets, word lengths, counts, character arena), each
+// starting on a 64-byte boundary. A mapped file is used in place: lookups
+// probe the stored hash table directly, so loading parses and rebuilds
+// nothing. Several processes mapping the same file share its page-cache pages.
+// Integers are stored in host byte order; byteOrder detects a foreign file.
+// A feature-hashing model (see FeatureTable.h) stores its counter array as
+// one more section, and its vocabulary is empty.
+struct ModelHeader {
+    char magic[8];           // "SNTMODEL"
+    uint32_t version;        // MODEL_FORMAT_VERSION
+    uint32_t byteOrder;      // MODEL_BYTE_ORDER as written by the host
+    uint64_t fileSize;
+    uint64_t numWords;
+    uint64_t numSlots;
+    uint64_t arenaBytes;
+    uint64_t slotsOffset;
+    uint64_t offsetsOffset;
+    uint64_t lengthsOffset;
+    uint64_t countsOffset;
+    uint64_t arenaOffset;
+    double countScale;       // See ModelInfo
+    uint32_t featureBits;    // FeatureTable bits, 0 if none
+    uint32_t reserved;
+    uint64_t featuresOffset; // 2^featureBits WordCount
+};
+
+// Model-wide values stored alongside the vocabulary
+struct ModelInfo {
+    // Effective count of a word = stored count * countScale. Decaying a model
+    // only lowers the scale; the stored counts are rescaled once it gets small.
+    double countScale = 1.0;
+};
+
+// Only files of this version are read. Words sit in the slots by the
+// word-at-a-time hashCharacters, so a file laid out by another hash or
+// layout must carry a different version.
+const uint32_t MODEL_FORMAT_VERSION = 5;
+const uint32_t MODEL_BYTE_ORDER = 0x01020304;
+
+// Writes vocabulary, and features if given and enabled, to path; throws
+// std::runtime_error on I/O failure. The file is written under a temporary
+// name and renamed over path, so readers (including a mapping of the old
+// file) never see a partial model.
+void saveModel(const Vocabulary& vocabulary, const char* path, const ModelInfo& info = ModelInfo(),
+               const FeatureTable* features = nullptr);
+
+// Validates a mapped model file and attaches vocabulary to its arrays; the
+// mapping must outlive the attached vocabulary. Besides the header, every
+// slot id and word extent is checked (one pass over the vocabulary), since
+// lookups index through them unchecked.
+// Fills info if given. If features is given it is attached to the file's
+// hashed feature section, or reset to disabled if the file has none.
+// Throws std::runtime_error if the file is not a compatible model.
+void attachModel(const MappedFile& file, Vocabulary& vocabulary, ModelInfo* info = nullptr,
+                 FeatureTable* features = nullptr);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef RUN_STATS_H
+#define RUN_STATS_H
+
+#include "LatencyHistogram.h"
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Monotonic clock reading used for all phase and latency timing
+inline uint64_t nowNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Largest resident set size of this process so far, in bytes (getrusage)
+uint64_t peakRssBytes();
+
+// Time spent in one phase of a run, with the work it covered
+struct PhaseStats {
+    std::string name;           // "train", "predict", ... or "train.parse" for a step inside one
+    double ms = 0;
+    bool summedOverThreads = false;  // ms is busy time added up across workers, not wall time
+    uint64_t tweets = 0;
+    uint64_t bytes = 0;
+};
+
+// Size of the model the run ended with
+struct VocabularyStats {
+    uint64_t words = 0;
+    uint64_t slots = 0;            // Hash table capacity
+    uint64_t heapBytes = 0;        // Table, arena and per-word arrays owned in memory
+    uint64_t mappedBytes = 0;      // Model file mapped in place of heap storage
+    uint64_t scoreTableBytes = 0;  // Frozen per-word weights
+    uint64_t featureBits = 0;      // Hashed feature table, if any: 2^bits counters
+    uint64_t featureBytes = 0;     // Its counters, owned or mapped
+};
+
+// Measurements a SentimentClassifier collects while a RunStats is attached
+// with setStats(). Without one nothing is timed: per-tweet timing happens in
+// separate loops selected once per batch, so the plain paths are unchanged.
+struct RunStats {
+    unsigned threads = 1;
+    std::vector<PhaseStats> phases;
+    VocabularyStats vocabulary;
+    LatencyHistogram predictLatency;  // predict scoring, per tweet
+
+    // Appends a phase; ms is taken from two nowNanos() readings
+    void addPhase(const char* name, uint64_t startNs, uint64_t endNs,
+                  uint64_t tweets = 0, uint64_t bytes = 0);
+    // Appends a step whose time was summed over worker threads
+    void addThreadPhase(const char* name, uint64_t busyNs);
+
+    void writeJson(std::ostream& out) const;
+};
+
+#endif
@@ -0,0 +1,99 @@
+#ifndef SCORING_MATRIX_H
+#define SCORING_MATRIX_H
+
+#include "SentimentClassifier.h"
+#include "Lexicon.h"
+#include "Tokenizer.h"
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+// A batch of tweets as a sparse matrix in CSR form, for scoring many tweets at
+// once (see SentimentClassifier::classifyBatch). Row r holds the scored words
+// of tweet r in order, each as a column of a dense weight table, plus what the
+// scoring rule needs besides word weights: strong indicator and emoticon
+// counts and whether a negation was left pending. Rows depend on the token
+// flags only, so one matrix can be scored under any ClassifierParams and any
+// weight table (the sweep scores the same matrix once per setting).
+//
+// score() runs the scoring rule of SentimentClassifier::scoreTokens over every
+// row. The AVX2 kernel scores four rows at a time, one per lane: step j
+// gathers the j-th word weights of all four rows, so each row is still summed
+// in token order and the decisions are exactly those of the scalar rule.
+class ScoringMatrix {
+public:
+    // What a row needs besides its word weights
+    struct Row {
+        uint32_t strongPositive = 0;  // Tokens with LEX_SCORE_POSITIVE
+        uint32_t strongNegative = 0;  // Tokens with LEX_SCORE_NEGATIVE
+        uint32_t smiles = 0;          // Tokens with TOKEN_SMILE
+        uint32_t frowns = 0;          // Tokens with TOKEN_FROWN
+        bool pendingNegation = false;  // A negation no later word consumed
+    };
+
+    // columnOf's answer for a token without a scored word
+    static constexpr uint32_t NO_COLUMN = UINT32_MAX;
+    // Columns are stored shifted left by one (the low bit marks a negated word)
+    static constexpr uint32_t MAX_COLUMN = UINT32_MAX >> 1;
+
+    ScoringMatrix() { clear(); }
+
+    // Appends one tweet's token records as a row. columnOf(token) returns the
+    // weight column of the token's word, or NO_COLUMN if it has none; an
+    // unseen word needs a column whose weights are 0, as scoreTokens gives it.
+    // Throws std::runtime_error past MAX_COLUMN or UINT32_MAX entries.
+    template <typename TokenType, typename ColumnOf>
+    void addRow(const TokenType* begin, const TokenType* end, ColumnOf columnOf);
+
+    // Removes all rows, keeping the capacity
+    void clear();
+
+    size_t numRows() const { return rows.size(); }
+    size_t numEntries() const { return entries.size(); }
+    size_t memoryUsage() const;
+
+    // Scores every row into results[row] (4 = positive, 0 = negative) against
+    // weights, indexed by column. SSE2 has no gathers and runs the scalar kernel.
+    void score(const WordWeight* weights, const ClassifierParams& params, int* results,
+               Tokenizer::Isa isa = Tokenizer::detectIsa()) const;
+
+private:
+    void addEntry(uint32_t column, bool negated) {
+        if (column > MAX_COLUMN || entries.size() == UINT32_MAX) {
+            throw std::runtime_error("Scoring matrix is too large");
+        }
+        entries.push_back(column << 1 | (negated ? 1 : 0));
+    }
+
+    std::vector<uint32_t> rowStart;  // numRows() + 1 offsets into entries
+    std::vector<uint32_t> entries;   // column << 1 | negated, row by row
+    std::vector<Row> rows;
+};
+
+// The token walk of scoreTokens, minus the weights: a negation applies to the
+// next scored word and is otherwise left pending
+template <typename TokenType, typename ColumnOf>
+void ScoringMatrix::addRow(const TokenType* begin, const TokenType* end, ColumnOf columnOf) {
+    Row row;
+    bool hasNegation = false;
+    for (const TokenType* token = begin; token != end; token++) {
+        if (token->rawFlags & LEX_SCORE_POSITIVE) row.strongPositive++;
+        if (token->rawFlags & LEX_SCORE_NEGATIVE) row.strongNegative++;
+        if (token->marks & TOKEN_SMILE) row.smiles++;
+        if (token->marks & TOKEN_FROWN) row.frowns++;
+        if (token->rawFlags & LEX_NEGATION) {
+            hasNegation = true;
+            continue;
+        }
+        uint32_t column = columnOf(*token);
+        if (column != NO_COLUMN) {
+            addEntry(column, hasNegation);
+            hasNegation = false;
+        }
+    }
+    row.pendingNegation = hasNegation;
+    rows.push_back(row);
+    rowStart.push_back(static_cast<uint32_t>(entries.size()));
+}
+
+#endif
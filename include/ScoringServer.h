@@ -0,0 +1,63 @@
+#ifndef SCORING_SERVER_H
+#define SCORING_SERVER_H
+
+#include "SentimentClassifier.h"
+#include "ThreadPool.h"
+#include "LatencyHistogram.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Long-running scorer for `sentiment serve`.
+// Requests are newline-delimited test-file rows (id,date,query,user,text) and
+// each is answered with a "sentiment,id" line, in request order, exactly as
+// predict() would write it. Header rows and blank lines get no answer. A
+// request line over 1 MiB is answered with an "error,..." line and ends the
+// connection.
+// Whatever a single read returns is scored as one batch, so a loaded client
+// that pipelines requests is batched automatically; large batches are split
+// across the thread pool. Latency is measured per request from the read that
+// delivered it to the write that answered it.
+class ScoringServer {
+public:
+    // classifier must be frozen and must outlive the server
+    ScoringServer(const SentimentClassifier& classifier, unsigned threads);
+
+    // Serves one connection until end of input, a write error or stop()
+    void serveStream(int inFd, int outFd);
+    // Accepts connections on a Unix domain socket until stop(), serving each
+    // on its own thread and reporting the running totals as each one closes.
+    // An existing socket file at path is replaced; any other file is an error.
+    // Out of descriptors, it waits for connections to close; any other accept
+    // failure stops the server and throws std::runtime_error.
+    void serveSocket(const char* path);
+
+    // Asks every serving loop to finish; safe to call from a signal handler
+    static void stop();
+    // Routes SIGINT/SIGTERM to stop() and ignores SIGPIPE
+    static void installSignalHandlers();
+
+    // Writes a one-line summary of everything served so far
+    void report(std::ostream& out) const;
+
+private:
+    struct StreamStats {
+        LatencyHistogram latency;
+        uint64_t batches = 0;
+    };
+
+    void scoreBatch(const std::vector<CsvField>& texts, std::vector<int>& results);
+
+    const SentimentClassifier& classifier;
+    ThreadPool pool;
+    std::mutex poolMutex;  // The pool runs one batch at a time
+
+    mutable std::mutex statsMutex;
+    StreamStats total;
+
+    static std::atomic<bool> stopping;
+};
+
+#endif
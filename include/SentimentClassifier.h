@@ -2,8 +2,16 @@
 #define SENTIMENT_CLASSIFIER_H
 
 #include "DSString.h"
+#include "CsvReader.h"
+#include "Vocabulary.h"
+#include "FeatureTable.h"
+#include "CountMinSketch.h"
+#include "Tokenizer.h"
+#include "RunStats.h"
 #include <vector>
-#include <unordered_map>
+
+class Corpus;
+class ScoringMatrix;
 
 // Represents a tweet with its metadata and sentiment (0=negative, 4=positive)
 class Tweet {
@@ -20,30 +28,225 @@ public:
     void setSentiment(int s) { sentiment = s; }
 };
 
+// Scoring weights of one word, precomputed from its counts by freeze()
+struct WordWeight {
+    double pos;  // pos / (pos + neg + 1)
+    double neg;  // neg / (pos + neg + 1)
+};
+
+// Tuning constants of training and scoring; the defaults are the tuned
+// values. `sentiment sweep` evaluates grids of them (see Sweep.h).
+struct ClassifierParams {
+    // Training weights of a word occurrence (ordinary words weigh 1)
+    int emoticonWeight = 4;         // Emoticons, which also decide the sentiment
+    int strongWordWeight = 3;       // Strong sentiment words of the lexicon
+    int emphaticWeight = 2;         // Words carrying "!!!" or "???"
+    // Scoring
+    double clarity = 0.2;           // A word counts if its pos/neg weights differ by more
+    double strongBoost = 0.8;       // Added per strong indicator token
+    double strongMultiplier = 1.5;  // Scales a side with a strong indicator and no pending negation
+    double emoticonBoost = 0.5;     // Added per smile or frown
+    double confidence = 0.15;       // Smaller score gaps fall back to the strong indicators
+};
+
+// Accuracy of one parameter setting in a sweep
+struct SweepResult {
+    ClassifierParams params;
+    uint64_t correct = 0;
+    uint64_t total = 0;  // Truth rows paired with a test tweet
+    double accuracy() const { return total > 0 ? static_cast<double>(correct) / total : 0; }
+};
+
+// Vocabulary pruning for training (see SentimentClassifier::setPruning)
+struct PruneOptions {
+    uint32_t minCount = 0;     // Count only words seen at least this often (0 or 1: all; at most 255)
+    size_t maxWords = 0;       // Then keep at most this many words (0: no limit)
+    unsigned sketchBits = 22;  // Count-min sketch rows of 2^bits one-byte counters (16 MiB)
+};
+
+// What the last pruned training pass kept and dropped
+struct PruneReport {
+    uint64_t droppedTokens = 0;  // Occurrences of words below minCount
+    uint64_t trimmedWords = 0;   // Words removed to meet maxWords
+    uint64_t words = 0;          // Words in the model afterwards
+    uint64_t modelBytes = 0;     // Vocabulary::memoryUsage afterwards
+    uint64_t sketchBytes = 0;    // Peak memory of the sketch
+};
+
+// True for common words that preprocessWord drops (never for sentiment-bearing words)
+bool isStopWord(DSStringView word);
+
 // Analyzes tweet sentiment using word frequency analysis
 // Training: O(N * W), Prediction: O(W), Space: O(V)
 // where N = tweets, W = words per tweet, V = vocabulary size
 class SentimentClassifier {
 private:
-    // Word frequency maps for sentiment analysis
-    std::unordered_map<DSString, int> positiveWords;
-    std::unordered_map<DSString, int> negativeWords;
+    // Interned vocabulary with per-word {pos, neg} counts
+    Vocabulary vocabulary;
+    // Feature-hashing mode (see setFeatureHashing): when enabled, unigram and
+    // bigram counts live here and the vocabulary stays empty
+    FeatureTable features;
+    // Model file backing vocabulary (or features) after loadModel
+    MappedFile modelMapping;
+    // Effective count = stored count * countScale; lowered by update() decay
+    double countScale = 1.0;
+    // Below this scale the stored counts are rescaled to keep them in range
+    static constexpr double MIN_COUNT_SCALE = 1.0 / 256;
+
+    // Immutable scoring table built by freeze(), indexed by vocabulary id.
+    // Scoring only reads it and the vocabulary, so it never grows the model
+    // and any number of threads can share it without locks. One extra zero
+    // entry at index vocabulary.size() is the column of unseen words in a
+    // ScoringMatrix.
+    std::vector<WordWeight> wordWeights;
+    bool frozen = false;
+
+    // Tuning constants used by training and scoring
+    ClassifierParams params;
+
+    // Vocabulary pruning; inactive unless minCount > 1 or maxWords > 0
+    PruneOptions pruning;
+    PruneReport pruneReport;
+
+    // Number of worker threads used by the parallel phases (1 = serial)
+    unsigned numThreads = 1;
+    // Instrumentation sink; nullptr disables all timing
+    RunStats* stats = nullptr;
     
-    // Core text processing functions
-    std::vector<DSString> tokenize(const DSString& text);
-    void updateWordFrequency(const DSString& word, bool isPositive);
-    int predictSentiment(const DSString& text);
-    DSString preprocessWord(const DSString& word);
+    // Core model functions
+    void updateWordFrequency(const DSString& word, bool isPositive, Vocabulary& counts);
+    void updateWordFrequency(const Token& token, bool isPositive, Vocabulary& counts);
+    static int wordWeight(const ClassifierParams& params, uint8_t lexiconWeight, uint16_t flags, bool emphatic,
+                          bool& isPositive);
+    int predictSentiment(DSStringView text) const;
+    template <typename TokenType, typename WordOf>
+    static int scoreTokens(const ClassifierParams& params, const TokenType* begin, const TokenType* end,
+                           WordOf wordOf);
+
+    // What a token's word contributes to scoreTokens
+    enum FeatureKind { FEATURE_NONE, FEATURE_WORD, FEATURE_BIGRAM };
+    // A bigram replaces its word's unigram once its effective count reaches this
+    static constexpr double MIN_BIGRAM_COUNT = 3;
+    static WordWeight weightOf(const WordCount& count, double scale);
+    FeatureKind hashedWeights(const uint64_t* previousHash, uint64_t hash, WordWeight& weight) const;
+
+    // Busy time of one training shard, split by step (collected only when Timed)
+    struct TrainTimes {
+        uint64_t parseNs = 0;
+        uint64_t tokenizeNs = 0;
+        uint64_t countNs = 0;
+        uint64_t tweets = 0;
+    };
+
+    // Where a training pass counts: word counts, or hashed features when
+    // enabled. With a sketch, only words admitted by admits() are counted.
+    struct CountTarget {
+        Vocabulary& counts;
+        FeatureTable& hashed;
+        const CountMinSketch* sketch;
+        uint64_t droppedTokens;
+    };
+    bool admits(const CountTarget& target, DSStringView word, uint64_t hash) const {
+        return target.sketch->estimate(hash) >= pruning.minCount ||
+               vocabulary.find(word, hash) != Vocabulary::NOT_FOUND;
+    }
+
+    // Training helpers; each shard covers the lines in [begin, end) of the mapped file
+    template <bool Timed>
+    void trainLine(const CsvField& line, CountTarget& target, TrainTimes& times);
+    template <bool Timed>
+    void trainShard(const char* begin, const char* end, CountTarget& target, TrainTimes& times);
+    void countFile(const DSString& trainingFile, CountTarget& target);
+    void countCorpus(const Corpus& corpus, CountTarget& target, uint64_t start, uint64_t bytes);
+    CountMinSketch sketchFile(const DSString& trainingFile);
+    void trimVocabulary(size_t maxWords);
+    void rescaleCounts();
+    void recordVocabularyStats();
 
 public:
     SentimentClassifier() = default;
+
+    // Text processing functions (stateless; public so benchmarks can drive them)
+    std::vector<DSStringView> tokenize(DSStringView text) const;
+    DSString preprocessWord(DSStringView word) const;
+    // Counts one preprocessed word into the model
+    void updateWordFrequency(const DSString& word, bool isPositive);
+
+    const Vocabulary& getVocabulary() const { return vocabulary; }
+    const FeatureTable& getFeatures() const { return features; }
+
+    // Switches to feature hashing: unigrams and bigrams of the normalized
+    // words are counted in a fixed table of 2^bits counters (see
+    // FeatureTable.h), so model memory is set here rather than by the data.
+    // bits = 0 returns to the exact word vocabulary (the default). Clears the
+    // model; a loaded model brings its own mode. Throws std::runtime_error
+    // for bits outside [FeatureTable::MIN_BITS, FeatureTable::MAX_BITS].
+    void setFeatureHashing(unsigned bits);
+
+    // Training weights apply to counts added afterwards; scoring constants
+    // take effect immediately
+    void setParams(const ClassifierParams& values) { params = values; }
+    const ClassifierParams& getParams() const { return params; }
+
+    // Bounds the vocabulary on large training sets. Training first passes over
+    // the file to count word occurrences in a count-min sketch (fixed memory),
+    // then counts only words whose estimate reaches minCount, plus words the
+    // model already has; so rare typos, handles and URLs never enter the
+    // vocabulary. maxWords then keeps the words with the highest counts.
+    // Not available with feature hashing, whose memory is already fixed.
+    void setPruning(const PruneOptions& options) { pruning = options; }
+    // Filled by each train() or update() while pruning is on
+    const PruneReport& getPruneReport() const { return pruneReport; }
+    bool isPruning() const { return pruning.minCount > 1 || pruning.maxWords > 0; }
+
+    // Sets the worker count for training and prediction (0 = use all hardware threads)
+    void setThreads(unsigned threads);
+    unsigned getThreads() const { return numThreads; }
+    
+    // Collects phase timings, model size and per-tweet latency into sink
+    // (see RunStats.h); nullptr, the default, turns collection off
+    void setStats(RunStats* sink) { stats = sink; }
+    
+    // Model persistence (see ModelFile.h); loadModel maps the file and uses it in place
+    void saveModel(const DSString& modelFile) const;
+    void loadModel(const DSString& modelFile);
+    
+    // Precomputes per-word weights for scoring; predict() freezes automatically.
+    // Any later training or loading thaws the model again.
+    void freeze();
+    bool isFrozen() const { return frozen; }
+    
+    // Scores one tweet text (4 = positive, 0 = negative) with a frozen model.
+    // Read-only, so concurrent calls from several threads are safe.
+    int classify(DSStringView text) const;
+    // Scores count texts into results, the same decisions classify() makes for
+    // each, as one ScoringMatrix scored by its SIMD kernel (matrix is a reusable
+    // workspace). Hashed models score the texts one at a time.
+    void classifyBatch(const DSStringView* texts, size_t count, int* results, ScoringMatrix& matrix,
+                       Tokenizer::Isa isa = Tokenizer::detectIsa()) const;
     
     // Main classifier operations
+    // train adds a file's counts to the current model (which may be loaded)
     void train(const DSString& trainingFile);
+    // Incremental training: multiplies the existing counts by decay (1 = keep
+    // everything), then adds the batch. Counting the batch costs time in the
+    // batch size; the rest is O(model): the first count added to a loaded
+    // (mapped) model copies its vocabulary and feature table, saving rewrites
+    // the whole file, and decay, though usually folded into one scale factor,
+    // rescales every count once that factor falls below MIN_COUNT_SCALE.
+    void update(const DSString& batchFile, double decay = 1.0);
     void predict(const DSString& testFile, const DSString& predictionsFile);
     void evaluatePredictions(const DSString& groundTruthFile, 
                            const DSString& predictionsFile,
                            const DSString& accuracyFile);
+    // Accuracy of every setting in grid, each as if trained on trainingFile
+    // and scored on testFile from scratch. Both files are tokenized once (a
+    // CSV is compiled to a temporary corpus); each setting then derives its
+    // word weights from per-word occurrence counts and scores the test tweets,
+    // held in ScoringMatrix form, settings running in parallel. Independent
+    // of the current model.
+    std::vector<SweepResult> sweep(const DSString& trainingFile, const DSString& testFile,
+                                   const DSString& groundTruthFile, const std::vector<ClassifierParams>& grid);
 };
 
 #endif 
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "SentimentClassifier.h"
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Parameter grids for `sentiment sweep` (see SentimentClassifier::sweep).
+// Parameters are named as in the results header:
+//   emoticon_weight, strong_weight, emphatic_weight  (positive integers)
+//   clarity, strong_boost, strong_multiplier, emoticon_boost, confidence
+
+// One swept parameter and its values
+struct SweepAxis {
+    std::string name;
+    std::vector<double> values;
+};
+
+// Sets the named parameter; throws std::runtime_error for an unknown name or
+// a weight that is not a positive integer
+void setClassifierParam(ClassifierParams& params, const std::string& name, double value);
+
+// Parses "name=value" into params (the --param option)
+void parseClassifierParam(ClassifierParams& params, const std::string& spec);
+
+// Parses "name=v1,v2,..."; throws std::runtime_error if malformed
+SweepAxis parseSweepAxis(const std::string& spec);
+
+// Every combination of the axes' values applied to base, the last axis
+// varying fastest; a single setting (base) if there are no axes.
+// Throws std::runtime_error for invalid values.
+std::vector<ClassifierParams> expandGrid(const ClassifierParams& base, const std::vector<SweepAxis>& axes);
+
+// One CSV row per result: every parameter, then accuracy, correct, total
+void writeSweepResults(const std::vector<SweepResult>& results, std::ostream& out);
+
+#endif
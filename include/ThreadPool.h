@@ -0,0 +1,53 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads that runs data-parallel loops.
+// The calling thread takes part in every loop, so a pool of size 1 starts
+// no threads at all and simply runs the loop inline.
+class ThreadPool {
+public:
+    using RangeFn = std::function<void(size_t begin, size_t end)>;
+
+    explicit ThreadPool(unsigned threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Splits [0, count) into contiguous chunks and calls body(begin, end) for each,
+    // returning once every chunk has finished. The first exception thrown by
+    // any chunk is rethrown here.
+    void parallelFor(size_t count, const RangeFn& body);
+
+private:
+    void workerLoop();
+    void runChunks();
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    // Current job, guarded by mutex
+    const RangeFn* job = nullptr;
+    size_t jobCount = 0;
+    size_t chunkSize = 0;
+    size_t nextChunk = 0;
+    size_t numChunks = 0;
+    size_t activeRunners = 0;
+    unsigned long generation = 0;
+    bool stopping = false;
+    std::exception_ptr failure;
+};
+
+#endif
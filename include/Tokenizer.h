@@ -0,0 +1,87 @@
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+#include "DSString.h"
+#include <cstdint>
+#include <vector>
+
+// Marks derived from a token's raw text
+enum TokenMark : uint8_t {
+    TOKEN_SMILE    = 1 << 0,  // Raw text contains ":)" or ":D"
+    TOKEN_FROWN    = 1 << 1,  // Raw text contains ":("
+    TOKEN_EMPHATIC = 1 << 2   // Normalized word contains "!!!" or "???"
+};
+
+// One token of a tweet, with everything training and scoring need about it
+struct Token {
+    DSStringView raw;      // Token as SentimentClassifier::tokenize splits it
+    DSStringView word;     // SentimentClassifier::preprocessWord(raw); empty if dropped
+    uint16_t rawFlags;     // Lexicon flags of raw, lowercased
+    uint16_t wordFlags;    // Lexicon flags of word
+    uint8_t trainWeight;   // Lexicon training weight of word (1 if none)
+    uint8_t marks;         // TokenMark bits
+};
+
+// Fused, table-driven tokenizer and normalizer.
+// A single pass over the tweet splits it exactly like tokenize(), and while
+// each byte is visited it is also lowercased for the lexicon check and
+// letter-filtered into the normalized word, so every tweet byte is read once.
+// The result is identical to tokenize() followed by preprocessWord() and
+// the per-token lexicon lookups.
+//
+// Runs of ordinary word bytes (anything but delimiters, '!', '?', '.' and
+// emoticon leads) are handled by a block kernel: on x86-64 it classifies
+// 16 (SSE2) or 32 (AVX2) bytes per step, finds the run end from a bitmask
+// and lowercases/filters the whole block at once. Boundaries, emoticons and
+// punctuation stay on the scalar path. The kernel is picked at runtime.
+//
+// A Tokenizer reuses its buffers between calls, so keep one per thread.
+class Tokenizer {
+public:
+    enum class Isa { Scalar, SSE2, AVX2 };
+
+    // Uses the best kernel the CPU supports unless told otherwise
+    Tokenizer() : Tokenizer(detectIsa()) {}
+    explicit Tokenizer(Isa isa);
+
+    // Tokenizes text; the result (and the word views in it) stays valid
+    // until the next call. Raw views point into text.
+    const std::vector<Token>& run(DSStringView text);
+
+    Isa getIsa() const { return isa; }
+    static Isa detectIsa();
+    static bool isSupported(Isa isa);
+    static const char* isaName(Isa isa);
+
+    static constexpr size_t MAX_LEXICON_LENGTH = 32;  // No lexicon word is longer
+    static constexpr size_t BLOCK_SLACK = 32;         // Kernels store whole blocks past the end
+
+    // Block kernel: consumes ordinary bytes from src (at most n) and returns
+    // how many. Appends lowercased letters to word[wordLength...] and the
+    // lowercased bytes to lowered[length...] while length < MAX_LEXICON_LENGTH.
+    using PlainRunKernel = size_t (*)(const char* src, size_t n, char* word, size_t& wordLength,
+                                      char* lowered, size_t& length);
+
+private:
+    // Per-byte step: records class bits, the lowercase byte and, for letters, the normalized byte
+    inline void pushByte(char c, uint8_t cls);
+    // Completes the token whose bytes were pushed and appends it to tokens
+    void finishToken(const char* begin, size_t length);
+    // Forgets the bytes pushed so far without producing a token
+    void discardToken();
+
+    Isa isa;
+    PlainRunKernel plainRun;
+
+    std::vector<Token> tokens;
+    std::vector<char> words;  // Normalized words, back to back (+ BLOCK_SLACK)
+    size_t wordsUsed = 0;
+
+    // State of the token being collected
+    size_t currentLength = 0;
+    size_t currentWordLength = 0;
+    uint8_t currentClasses = 0;
+    char lowered[MAX_LEXICON_LENGTH + BLOCK_SLACK];  // Lowercased prefix of the raw token
+};
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef VOCABULARY_H
+#define VOCABULARY_H
+
+#include "DSString.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Positive and negative counts of one vocabulary word, stored side by side
+struct WordCount {
+    int32_t pos = 0;
+    int32_t neg = 0;
+};
+
+// Interned vocabulary: a flat open-addressing hash table (linear probing,
+// power-of-two capacity) mapping each distinct word to a dense id, plus
+// contiguous per-id arrays for the word text and its {pos, neg} counts.
+// Words are copied once into a shared character arena; lookups take views,
+// so no key object is ever built to probe the table.
+//
+// All lookups go through raw array views, which point either at the vectors
+// owned by this object or at an attached read-only buffer (a mapped model
+// file). Mutating an attached vocabulary first copies it into owned storage.
+// Lookup: O(1) expected, Space: O(V) for V distinct words
+class Vocabulary {
+public:
+    static constexpr uint32_t NOT_FOUND = UINT32_MAX;
+
+    struct Slot {
+        uint32_t id;    // Dense word id, or NOT_FOUND for an empty slot
+        uint32_t tag;   // High bits of the hash, compared before the text
+    };
+
+    // Raw arrays making up a vocabulary, as stored in a model file
+    struct Layout {
+        const Slot* slots;
+        size_t numSlots;          // Power of two
+        const char* arena;
+        size_t arenaBytes;
+        const uint32_t* offsets;  // numWords entries
+        const uint32_t* lengths;  // numWords entries
+        const WordCount* counts;  // numWords entries
+        size_t numWords;
+    };
+
+    Vocabulary();
+    Vocabulary(const Vocabulary& other);
+    Vocabulary& operator=(const Vocabulary& other);
+
+    // Id of word, or NOT_FOUND if it has never been added
+    uint32_t find(DSStringView word) const { return find(word, hashWord(word)); }
+    // Id of word, adding it with zero counts if missing
+    uint32_t intern(DSStringView word) { return intern(word, hashWord(word)); }
+    // Same, for callers that already hold hashWord(word), e.g. DSString::hash()
+    uint32_t find(DSStringView word, uint64_t hash) const;
+    uint32_t intern(DSStringView word, uint64_t hash);
+
+    // Counts for word, or nullptr if unseen (read-only, safe across threads)
+    const WordCount* lookup(DSStringView word) const;
+    WordCount& counts(uint32_t id);
+    const WordCount& counts(uint32_t id) const { return countView[id]; }
+
+    // Adds to the counts of word, interning it first if needed
+    void add(DSStringView word, int pos, int neg) { add(word, hashWord(word), pos, neg); }
+    void add(DSStringView word, uint64_t hash, int pos, int neg);
+    // Adds every word and count of other into this vocabulary
+    void merge(const Vocabulary& other);
+
+    DSStringView word(uint32_t id) const;
+    size_t size() const { return numWords; }
+    bool empty() const { return numWords == 0; }
+    void clear();
+    // Exchanges contents (and storage) with other; copies nothing
+    void swap(Vocabulary& other);
+
+    // Arrays backing the current contents
+    Layout layout() const;
+    // Serves lookups straight from external arrays, which must outlive this
+    // object (or the next mutation). Nothing is copied or rebuilt.
+    void attach(const Layout& external);
+    bool isAttached() const { return attached; }
+
+    // Bytes of heap memory held by the table, arena and per-id arrays
+    size_t memoryUsage() const;
+
+    // Well-mixed 64-bit hash of a word; every bit is usable for bucketing.
+    // The same value as DSString::hash() of an equal string.
+    static uint64_t hashWord(DSStringView word) { return hashCharacters(word.data(), word.getLength()); }
+
+private:
+    size_t probe(DSStringView word, uint64_t hash) const;
+    void grow();
+    // Replaces the slots with numSlots (a power of two) filled from the word texts
+    void rebuildSlots(size_t numSlots);
+    void syncViews();
+    void makeWritable();
+    void copyFrom(const Layout& source);
+
+    // Owned storage (unused while attached)
+    std::vector<Slot> slots;
+    std::vector<char> arena;              // All word characters back to back
+    std::vector<uint32_t> wordOffsets;    // Per id: start of the word in arena
+    std::vector<uint32_t> wordLengths;    // Per id: length of the word
+    std::vector<WordCount> wordCounts;    // Per id: {pos, neg}
+
+    // Views used by every lookup
+    const Slot* slotView;
+    size_t mask;                          // Number of slots - 1
+    const char* arenaView;
+    size_t arenaSize;
+    const uint32_t* offsetView;
+    const uint32_t* lengthView;
+    const WordCount* countView;
+    size_t numWords;
+    bool attached;
+};
+
+#endif
@@ -0,0 +1,63 @@
+#include "Arena.h"
+#include <cstdint>
+#include <new>
+
+Arena::Arena(size_t blockSize) : blockSize(blockSize > 0 ? blockSize : DEFAULT_BLOCK_SIZE) {}
+
+Arena::~Arena() {
+    for (const auto& block : blocks) {
+        ::operator delete(block.data);
+    }
+}
+
+void* Arena::allocate(size_t bytes, size_t alignment) {
+    uintptr_t address = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(alignment - 1);
+    char* start = reinterpret_cast<char*>(address);
+    if (cursor == nullptr || start > limit || bytes > static_cast<size_t>(limit - start)) {
+        nextBlock(bytes, alignment);
+        address = (reinterpret_cast<uintptr_t>(cursor) + alignment - 1) & ~(alignment - 1);
+        start = reinterpret_cast<char*>(address);
+    }
+    cursor = start + bytes;
+    return start;
+}
+
+void Arena::nextBlock(size_t bytes, size_t alignment) {
+    size_t needed = bytes + alignment;
+    if (cursor != nullptr) {
+        usedBefore += static_cast<size_t>(cursor - blocks[current].data);
+        current++;
+    }
+    // Reuse a kept block if one is big enough; smaller ones are skipped this round
+    while (current < blocks.size() && blocks[current].size < needed) {
+        current++;
+    }
+    if (current >= blocks.size()) {
+        size_t size = needed > blockSize ? needed : blockSize;
+        blocks.push_back(Block{static_cast<char*>(::operator new(size)), size});
+        current = blocks.size() - 1;
+    }
+    cursor = blocks[current].data;
+    limit = cursor + blocks[current].size;
+}
+
+void Arena::reset() {
+    current = 0;
+    usedBefore = 0;
+    if (blocks.empty()) {
+        cursor = limit = nullptr;
+    } else {
+        cursor = blocks[0].data;
+        limit = cursor + blocks[0].size;
+    }
+}
+
+size_t Arena::bytesUsed() const {
+    return cursor ? usedBefore + static_cast<size_t>(cursor - blocks[current].data) : 0;
+}
+
+size_t Arena::bytesReserved() const {
+    size_t total = 0;
+    for (const auto& block : blocks) total += block.size;
+    return total;
+}
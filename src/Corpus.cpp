@@ -0,0 +1,300 @@
+#include "Corpus.h"
+#include "Lexicon.h"
+#include "ModelFile.h"
+#include "Tokenizer.h"
+#include "Vocabulary.h"
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <vector>
+
+namespace {
+    const char CORPUS_MAGIC[8] = {'S', 'N', 'T', 'C', 'O', 'R', 'P', 'S'};
+    const uint64_t SECTION_ALIGNMENT = 64;
+    // Bump when the Tokenizer's output for the same text changes
+    const char TOKENIZER_RULES[] = "tokenizer rules 1";
+    const size_t TOKEN_BUFFER_SIZE = 1 << 16;
+
+    uint64_t alignUp(uint64_t offset) {
+        return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+    }
+
+    // True if count items of size bytes from offset end at or before limit (without overflowing)
+    bool sectionFits(uint64_t offset, uint64_t count, uint64_t size, uint64_t limit) {
+        return offset <= limit && count <= (limit - offset) / size;
+    }
+
+    void writeSection(std::ofstream& out, uint64_t offset, const void* data, uint64_t bytes) {
+        static const char padding[SECTION_ALIGNMENT] = {};
+        uint64_t position = static_cast<uint64_t>(out.tellp());
+        out.write(padding, static_cast<std::streamsize>(offset - position));
+        if (bytes > 0) {
+            out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        }
+    }
+
+    int64_t modificationNanos(const struct stat& info) {
+        return static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+    }
+
+    // Tokens without a word, a scoring flag or an emoticon change nothing
+    bool isUseful(const Token& token) {
+        return !token.word.empty() ||
+               (token.rawFlags & (LEX_SCORE_POSITIVE | LEX_SCORE_NEGATIVE | LEX_NEGATION)) != 0 ||
+               (token.marks & (TOKEN_SMILE | TOKEN_FROWN)) != 0;
+    }
+}
+
+uint64_t lexiconFingerprint() {
+    std::string description = TOKENIZER_RULES;
+    for (size_t i = 1; i < lexicon::TABLE.numEntries; i++) {
+        const LexiconEntry& entry = lexicon::TABLE.entries[i];
+        description.append(entry.text, entry.length);
+        description += '\0';
+        description += static_cast<char>(entry.trainWeight);
+        description += static_cast<char>(entry.flags & 0xff);
+        description += static_cast<char>(entry.flags >> 8);
+    }
+    return hashCharacters(description.data(), description.size());
+}
+
+CorpusSummary compileCorpus(const char* csvPath, const char* corpusPath) {
+    MappedFile source(csvPath);
+    struct stat info;
+    if (!source.is_open() || stat(csvPath, &info) != 0) {
+        throw std::runtime_error("Unable to open CSV file");
+    }
+    CsvReader reader(source);
+    CsvField line;
+    if (!reader.nextLine(line)) {
+        throw std::runtime_error("CSV file is empty");
+    }
+    size_t columns = 1;
+    for (size_t i = 0; i < line.length; i++) {
+        columns += line.data[i] == ',';
+    }
+    if (columns != 6 && columns != 5) {
+        throw std::runtime_error("Unrecognized CSV header: expected 6 (training) or 5 (test) columns");
+    }
+    CorpusKind kind = columns == 6 ? CorpusKind::Training : CorpusKind::Test;
+    size_t idField = kind == CorpusKind::Training ? 1 : 0;
+    size_t textField = kind == CorpusKind::Training ? 5 : 4;
+
+    CorpusHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CORPUS_MAGIC, sizeof(header.magic));
+    header.version = CORPUS_FORMAT_VERSION;
+    header.byteOrder = MODEL_BYTE_ORDER;
+    header.kind = static_cast<uint32_t>(kind);
+    header.lexiconHash = lexiconFingerprint();
+    header.sourceSize = source.size();
+    header.sourceMtimeNs = modificationNanos(info);
+    header.sourceHash = hashCharacters(source.data(), source.size());
+    char resolved[PATH_MAX];
+    std::string sourcePath = realpath(csvPath, resolved) ? resolved : csvPath;
+
+    // Tokens are streamed straight after the header; the per-tweet arrays
+    // and the dictionary follow once their sizes are known
+    std::string tempPath = std::string(corpusPath) + ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Unable to open corpus file for writing");
+    }
+    header.tokensOffset = alignUp(sizeof(CorpusHeader));
+    writeSection(out, 0, &header, sizeof(header));
+    writeSection(out, header.tokensOffset, nullptr, 0);
+
+    Tokenizer tokenizer;
+    Vocabulary dictionary;
+    std::vector<CorpusWord> wordInfos;
+    std::vector<uint64_t> tweetTokens(1, 0);
+    std::vector<uint8_t> labels;
+    std::vector<uint64_t> idOffsets(1, 0);
+    std::vector<char> idArena;
+    std::vector<CorpusToken> pending;
+    pending.reserve(TOKEN_BUFFER_SIZE);
+    uint64_t numTokens = 0;
+    auto flush = [&]() {
+        out.write(reinterpret_cast<const char*>(pending.data()),
+                  static_cast<std::streamsize>(pending.size() * sizeof(CorpusToken)));
+        pending.clear();
+    };
+
+    while (reader.nextLine(line)) {
+        CsvField fields[6];
+        CsvReader::splitFields(line, fields, textField + 1);
+        CsvField id = fields[idField];
+        CsvField text = fields[textField].unquoted();
+        if (kind == CorpusKind::Training) {
+            labels.push_back(fields[0].equals("4") ? 4 : 0);
+        }
+        idArena.insert(idArena.end(), id.data, id.data + id.length);
+        idOffsets.push_back(idArena.size());
+
+        for (const Token& token : tokenizer.run(DSStringView(text.data, text.length))) {
+            if (!isUseful(token)) continue;
+            CorpusToken stored{CORPUS_NO_WORD, token.rawFlags, token.marks, 0};
+            if (!token.word.empty()) {
+                stored.word = dictionary.intern(token.word);
+                if (stored.word == wordInfos.size()) {
+                    wordInfos.push_back(CorpusWord{token.wordFlags, token.trainWeight, 0});
+                }
+            }
+            pending.push_back(stored);
+            numTokens++;
+        }
+        tweetTokens.push_back(numTokens);
+        if (pending.size() >= TOKEN_BUFFER_SIZE) {
+            flush();
+        }
+    }
+    flush();
+
+    Vocabulary::Layout words = dictionary.layout();
+    uint64_t numTweets = tweetTokens.size() - 1;
+    header.numTweets = numTweets;
+    header.numTokens = numTokens;
+    header.tweetTokensOffset = alignUp(header.tokensOffset + numTokens * sizeof(CorpusToken));
+    header.labelsOffset = alignUp(header.tweetTokensOffset + (numTweets + 1) * sizeof(uint64_t));
+    header.idOffsetsOffset = alignUp(header.labelsOffset + labels.size());
+    header.idArenaOffset = alignUp(header.idOffsetsOffset + (numTweets + 1) * sizeof(uint64_t));
+    header.idArenaBytes = idArena.size();
+    header.numWords = words.numWords;
+    header.wordOffsetsOffset = alignUp(header.idArenaOffset + idArena.size());
+    header.wordLengthsOffset = alignUp(header.wordOffsetsOffset + words.numWords * sizeof(uint32_t));
+    header.wordInfoOffset = alignUp(header.wordLengthsOffset + words.numWords * sizeof(uint32_t));
+    header.wordArenaOffset = alignUp(header.wordInfoOffset + words.numWords * sizeof(CorpusWord));
+    header.wordArenaBytes = words.arenaBytes;
+    header.sourcePathOffset = alignUp(header.wordArenaOffset + words.arenaBytes);
+    header.sourcePathBytes = sourcePath.size();
+    header.fileSize = header.sourcePathOffset + sourcePath.size();
+
+    writeSection(out, header.tweetTokensOffset, tweetTokens.data(), tweetTokens.size() * sizeof(uint64_t));
+    writeSection(out, header.labelsOffset, labels.data(), labels.size());
+    writeSection(out, header.idOffsetsOffset, idOffsets.data(), idOffsets.size() * sizeof(uint64_t));
+    writeSection(out, header.idArenaOffset, idArena.data(), idArena.size());
+    writeSection(out, header.wordOffsetsOffset, words.offsets, words.numWords * sizeof(uint32_t));
+    writeSection(out, header.wordLengthsOffset, words.lengths, words.numWords * sizeof(uint32_t));
+    writeSection(out, header.wordInfoOffset, wordInfos.data(), wordInfos.size() * sizeof(CorpusWord));
+    writeSection(out, header.wordArenaOffset, words.arena, words.arenaBytes);
+    writeSection(out, header.sourcePathOffset, sourcePath.data(), sourcePath.size());
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out || std::rename(tempPath.c_str(), corpusPath) != 0) {
+        std::remove(tempPath.c_str());
+        throw std::runtime_error("Unable to write corpus file");
+    }
+    return CorpusSummary{kind, numTweets, numTokens, words.numWords, header.fileSize};
+}
+
+bool isCorpusFile(const MappedFile& file) {
+    return file.size() >= sizeof(CORPUS_MAGIC) &&
+           std::memcmp(file.data(), CORPUS_MAGIC, sizeof(CORPUS_MAGIC)) == 0;
+}
+
+std::optional<Corpus> openCorpusOrCsv(const char* path, MappedFile& file) {
+    if (!file.open(path) || !isCorpusFile(file)) {
+        return std::nullopt;
+    }
+    Corpus corpus(file);
+    if (!corpus.isStale()) {
+        return corpus;
+    }
+    std::string source = corpus.sourcePath();
+    std::cerr << "Warning: " << path << " is out of date with " << source
+              << "; reading the CSV instead" << std::endl;
+    file.open(source.c_str());
+    return std::nullopt;
+}
+
+Corpus::Corpus(const MappedFile& file) {
+    if (!isCorpusFile(file) || file.size() < sizeof(CorpusHeader)) {
+        throw std::runtime_error("Not a corpus file");
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.byteOrder != MODEL_BYTE_ORDER) {
+        throw std::runtime_error("Corpus file was written with a different byte order");
+    }
+    if (header.version != CORPUS_FORMAT_VERSION) {
+        throw std::runtime_error("Unsupported corpus file version");
+    }
+    // Sections must be aligned, in order and inside the file
+    bool training = header.kind == static_cast<uint32_t>(CorpusKind::Training);
+    uint64_t misaligned = header.tokensOffset | header.tweetTokensOffset | header.labelsOffset |
+                          header.idOffsetsOffset | header.idArenaOffset | header.wordOffsetsOffset |
+                          header.wordLengthsOffset | header.wordInfoOffset | header.wordArenaOffset |
+                          header.sourcePathOffset;
+    if (header.fileSize != file.size() || (!training && header.kind != static_cast<uint32_t>(CorpusKind::Test)) ||
+        misaligned % SECTION_ALIGNMENT != 0 || header.tokensOffset < sizeof(CorpusHeader) ||
+        header.numTweets == UINT64_MAX ||
+        !sectionFits(header.tokensOffset, header.numTokens, sizeof(CorpusToken), header.tweetTokensOffset) ||
+        !sectionFits(header.tweetTokensOffset, header.numTweets + 1, sizeof(uint64_t), header.labelsOffset) ||
+        !sectionFits(header.labelsOffset, training ? header.numTweets : 0, 1, header.idOffsetsOffset) ||
+        !sectionFits(header.idOffsetsOffset, header.numTweets + 1, sizeof(uint64_t), header.idArenaOffset) ||
+        !sectionFits(header.idArenaOffset, header.idArenaBytes, 1, header.wordOffsetsOffset) ||
+        !sectionFits(header.wordOffsetsOffset, header.numWords, sizeof(uint32_t), header.wordLengthsOffset) ||
+        !sectionFits(header.wordLengthsOffset, header.numWords, sizeof(uint32_t), header.wordInfoOffset) ||
+        !sectionFits(header.wordInfoOffset, header.numWords, sizeof(CorpusWord), header.wordArenaOffset) ||
+        !sectionFits(header.wordArenaOffset, header.wordArenaBytes, 1, header.sourcePathOffset) ||
+        !sectionFits(header.sourcePathOffset, header.sourcePathBytes, 1, file.size())) {
+        throw std::runtime_error("Corpus file is corrupt");
+    }
+
+    base = file.data();
+    tweetTokens = reinterpret_cast<const uint64_t*>(base + header.tweetTokensOffset);
+    labels = reinterpret_cast<const uint8_t*>(base + header.labelsOffset);
+    idOffsets = reinterpret_cast<const uint64_t*>(base + header.idOffsetsOffset);
+    idArena = base + header.idArenaOffset;
+    tokens = reinterpret_cast<const CorpusToken*>(base + header.tokensOffset);
+    wordOffsets = reinterpret_cast<const uint32_t*>(base + header.wordOffsetsOffset);
+    wordLengths = reinterpret_cast<const uint32_t*>(base + header.wordLengthsOffset);
+    wordInfos = reinterpret_cast<const CorpusWord*>(base + header.wordInfoOffset);
+    wordArena = base + header.wordArenaOffset;
+    if (tweetTokens[0] != 0 || tweetTokens[header.numTweets] != header.numTokens ||
+        idOffsets[0] != 0 || idOffsets[header.numTweets] != header.idArenaBytes) {
+        throw std::runtime_error("Corpus file is corrupt");
+    }
+
+    // Readers index through these arrays unchecked, so check them once here (a linear pass)
+    for (uint64_t tweet = 0; tweet < header.numTweets; tweet++) {
+        if (tweetTokens[tweet] > tweetTokens[tweet + 1] || idOffsets[tweet] > idOffsets[tweet + 1]) {
+            throw std::runtime_error("Corpus file is corrupt");
+        }
+    }
+    for (uint64_t token = 0; token < header.numTokens; token++) {
+        if (tokens[token].word >= header.numWords && tokens[token].word != CORPUS_NO_WORD) {
+            throw std::runtime_error("Corpus file is corrupt");
+        }
+    }
+    for (uint64_t word = 0; word < header.numWords; word++) {
+        if (!sectionFits(wordOffsets[word], wordLengths[word], 1, header.wordArenaBytes)) {
+            throw std::runtime_error("Corpus file is corrupt");
+        }
+    }
+}
+
+bool Corpus::isStale() const {
+    if (header.lexiconHash != lexiconFingerprint()) {
+        return true;
+    }
+    std::string path = sourcePath();
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0) {
+        return false;  // Source gone; the corpus is all there is
+    }
+    if (static_cast<uint64_t>(info.st_size) != header.sourceSize) {
+        return true;
+    }
+    if (modificationNanos(info) == header.sourceMtimeNs) {
+        return false;
+    }
+    // Touched but the same size: compare contents
+    MappedFile source(path.c_str());
+    return source.is_open() && hashCharacters(source.data(), source.size()) != header.sourceHash;
+}
@@ -0,0 +1,21 @@
+#include "CountMinSketch.h"
+#include <stdexcept>
+
+CountMinSketch::CountMinSketch(unsigned bits) : numBits(bits) {
+    if (bits < MIN_BITS || bits > MAX_BITS) {
+        throw std::runtime_error("Sketch bits must be between 10 and 30");
+    }
+    mask = static_cast<uint32_t>((uint64_t(1) << bits) - 1);
+    counters.assign(static_cast<size_t>(DEPTH) << bits, 0);
+}
+
+void CountMinSketch::merge(const CountMinSketch& other) {
+    if (other.numBits != numBits) {
+        throw std::runtime_error("Sketches differ in size");
+    }
+    for (size_t i = 0; i < counters.size(); i++) {
+        uint32_t count = other.counters[i];
+        counters[i] = static_cast<uint8_t>(count >= MAX_COUNT - counters[i] ? MAX_COUNT : counters[i] + count);
+    }
+    total += other.total;
+}
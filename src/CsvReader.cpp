@@ -0,0 +1,133 @@
+#include "CsvReader.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool CsvField::equals(const char* str) const {
+    size_t i = 0;
+    for (; i < length; i++) {
+        if (str[i] != data[i]) return false;
+    }
+    return str[i] == '\0';
+}
+
+CsvField CsvField::trimmed() const {
+    const char* first = data;
+    const char* last = data + length;
+    auto isSpace = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; };
+    while (first < last && isSpace(*first)) first++;
+    while (last > first && isSpace(last[-1])) last--;
+    return CsvField{first, static_cast<size_t>(last - first)};
+}
+
+CsvField CsvField::unquoted() const {
+    CsvField result = *this;
+    if (!result.empty() && result.front() == '"') {
+        result.data++;
+        result.length--;
+    }
+    if (!result.empty() && result.back() == '"') {
+        result.length--;
+    }
+    return result;
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const char* path, bool sequential) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    mapSize = static_cast<size_t>(info.st_size);
+    if (mapSize > 0) {
+        void* addr = mmap(nullptr, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            ::close(fd);
+            mapSize = 0;
+            return false;
+        }
+        madvise(addr, mapSize, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+        mapData = static_cast<const char*>(addr);
+    }
+    ::close(fd);  // The mapping keeps the file referenced
+    isOpen = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapData != nullptr) {
+        munmap(const_cast<char*>(mapData), mapSize);
+    }
+    mapData = nullptr;
+    mapSize = 0;
+    isOpen = false;
+}
+
+size_t MappedFile::dropPages(size_t begin, size_t end) const {
+    static const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t first = (begin + pageSize - 1) / pageSize * pageSize;
+    size_t last = (end < mapSize ? end : mapSize) / pageSize * pageSize;
+    if (mapData == nullptr || last <= first) {
+        return begin > last ? begin : last;
+    }
+    madvise(const_cast<char*>(mapData) + first, last - first, MADV_DONTNEED);
+    return last;
+}
+
+CsvReader::CsvReader(const MappedFile& file)
+    : cursor(file.data()), end(file.data() + file.size()) {}
+
+bool CsvReader::nextLine(CsvField& line) {
+    if (cursor >= end) {
+        return false;
+    }
+    const void* newline = std::memchr(cursor, '\n', static_cast<size_t>(end - cursor));
+    const char* lineEnd = newline ? static_cast<const char*>(newline) : end;
+    line = CsvField{cursor, static_cast<size_t>(lineEnd - cursor)};
+    cursor = newline ? lineEnd + 1 : end;
+    return true;
+}
+
+void CsvReader::splitFields(const CsvField& line, CsvField* out, size_t maxFields) {
+    const char* pos = line.data;
+    const char* lineEnd = line.data + line.length;
+    for (size_t i = 0; i < maxFields; i++) {
+        if (pos >= lineEnd && i > 0) {
+            out[i] = CsvField{};
+            continue;
+        }
+        const char* fieldEnd = lineEnd;
+        if (i + 1 < maxFields) {
+            const void* comma = std::memchr(pos, ',', static_cast<size_t>(lineEnd - pos));
+            if (comma) fieldEnd = static_cast<const char*>(comma);
+        }
+        out[i] = CsvField{pos, static_cast<size_t>(fieldEnd - pos)};
+        pos = fieldEnd < lineEnd ? fieldEnd + 1 : lineEnd;
+    }
+}
+
+std::vector<const char*> CsvReader::splitLines(const char* begin, const char* end, size_t parts) {
+    // Advance each even split point to the start of the next line
+    std::vector<const char*> bounds{begin};
+    for (size_t i = 1; i < parts; i++) {
+        const char* split = begin + (end - begin) * i / parts;
+        if (split < bounds.back()) split = bounds.back();
+        while (split < end && split > begin && split[-1] != '\n') split++;
+        bounds.push_back(split);
+    }
+    bounds.push_back(end);
+    return bounds;
+}
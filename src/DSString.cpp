@@ -1,13 +1,74 @@
 #include "DSString.h"
-#include <cstring>  // Only used in constructor to get string length
+#include <cstring>  // memcpy for the allocator stored in the inline buffer
+
+thread_local DSStringAllocator* DSString::threadAllocator = nullptr;
+
+static_assert(sizeof(DSStringAllocator*) <= DSString::SSO_CAPACITY + 1,
+              "Heap strings keep their allocator in the inline buffer");
+
+DSStringAllocator* DSString::setAllocator(DSStringAllocator* allocator) {
+    DSStringAllocator* previous = threadAllocator;
+    threadAllocator = allocator;
+    return previous;
+}
+
+/**
+ * @brief Allocator that owns the heap buffer (nullptr = operator new)
+ * Only meaningful for heap strings, whose inline buffer is otherwise unused
+ */
+DSStringAllocator* DSString::owner() const {
+    DSStringAllocator* allocator;
+    std::memcpy(&allocator, inlineBuffer, sizeof(allocator));
+    return allocator;
+}
+
+void DSString::setOwner(DSStringAllocator* allocator) {
+    std::memcpy(inlineBuffer, &allocator, sizeof(allocator));
+}
+
+/**
+ * @brief Reserves storage for len characters plus terminator
+ * @param len Number of characters the string will hold
+ * Uses the inline buffer when it is large enough, otherwise the heap
+ */
+void DSString::allocate(size_t len) {
+    length = len;
+    cachedHash.store(0, std::memory_order_relaxed);
+    if (len <= SSO_CAPACITY) {
+        data = inlineBuffer;
+    } else {
+        data = threadAllocator ? threadAllocator->allocateChars(len + 1) : new char[len + 1];
+        setOwner(threadAllocator);
+    }
+}
+
+/**
+ * @brief Adopts the cached hash of a string with the same contents
+ */
+void DSString::takeHash(const DSString& str) {
+    cachedHash.store(str.cachedHash.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Frees heap storage (inline storage needs no cleanup)
+ */
+void DSString::release() {
+    if (!isInline()) {
+        DSStringAllocator* allocator = owner();
+        if (allocator) {
+            allocator->deallocateChars(data, length + 1);
+        } else {
+            delete[] data;
+        }
+    }
+}
 
 /**
  * @brief Default constructor creates an empty string
- * Allocates minimum space for null terminator
+ * Uses the inline buffer, so no allocation takes place
  */
-DSString::DSString() : data(nullptr), length(0) {
-    data = new char[1];
-    data[0] = '\0';
+DSString::DSString() : data(inlineBuffer), length(0) {
+    inlineBuffer[0] = '\0';
 }
 
 /**
@@ -17,18 +78,30 @@ DSString::DSString() : data(nullptr), length(0) {
  */
 DSString::DSString(const char* str) {
     if (str == nullptr) {
-        data = new char[1];
+        allocate(0);
         data[0] = '\0';
-        length = 0;
         return;
     }
     
     // Calculate length manually to avoid cstring functions
-    length = 0;
-    while (str[length] != '\0') length++;
+    size_t len = 0;
+    while (str[len] != '\0') len++;
     
     // Allocate and copy characters
-    data = new char[length + 1];
+    allocate(len);
+    for (size_t i = 0; i < length; i++) {
+        data[i] = str[i];
+    }
+    data[length] = '\0';
+}
+
+/**
+ * @brief Constructs string from a buffer of known length
+ * @param str Source characters (not required to be null-terminated)
+ * @param len Number of characters to copy
+ */
+DSString::DSString(const char* str, size_t len) {
+    allocate(len);
     for (size_t i = 0; i < length; i++) {
         data[i] = str[i];
     }
@@ -40,11 +113,34 @@ DSString::DSString(const char* str) {
  * @param str Source DSString to copy from
  * Creates deep copy of the source string
  */
-DSString::DSString(const DSString& str) : length(str.length) {
-    data = new char[length + 1];
+DSString::DSString(const DSString& str) {
+    allocate(str.length);
     for (size_t i = 0; i <= length; i++) {
         data[i] = str.data[i];
     }
+    takeHash(str);
+}
+
+/**
+ * @brief Move constructor
+ * @param str Source DSString, left as an empty string
+ * Steals the heap buffer; inline strings are copied (at most SSO_CAPACITY bytes)
+ */
+DSString::DSString(DSString&& str) noexcept : length(str.length) {
+    if (str.isInline()) {
+        data = inlineBuffer;
+        for (size_t i = 0; i <= length; i++) {
+            data[i] = str.data[i];
+        }
+    } else {
+        data = str.data;
+        setOwner(str.owner());
+    }
+    takeHash(str);
+    str.data = str.inlineBuffer;
+    str.length = 0;
+    str.inlineBuffer[0] = '\0';
+    str.cachedHash.store(0, std::memory_order_relaxed);
 }
 
 /**
@@ -52,7 +148,7 @@ DSString::DSString(const DSString& str) : length(str.length) {
  * Frees dynamically allocated memory
  */
 DSString::~DSString() {
-    delete[] data;
+    release();
 }
 
 /**
@@ -63,12 +159,39 @@ DSString::~DSString() {
  */
 DSString& DSString::operator=(const DSString& str) {
     if (this != &str) {  // Self-assignment check
-        delete[] data;
-        length = str.length;
-        data = new char[length + 1];
+        release();
+        allocate(str.length);
         for (size_t i = 0; i <= length; i++) {
             data[i] = str.data[i];
         }
+        takeHash(str);
+    }
+    return *this;
+}
+
+/**
+ * @brief Move assignment operator
+ * @param str Source string, left as an empty string
+ * @return Reference to this object
+ */
+DSString& DSString::operator=(DSString&& str) noexcept {
+    if (this != &str) {  // Self-assignment check
+        release();
+        length = str.length;
+        if (str.isInline()) {
+            data = inlineBuffer;
+            for (size_t i = 0; i <= length; i++) {
+                data[i] = str.data[i];
+            }
+        } else {
+            data = str.data;
+            setOwner(str.owner());
+        }
+        takeHash(str);
+        str.data = str.inlineBuffer;
+        str.length = 0;
+        str.inlineBuffer[0] = '\0';
+        str.cachedHash.store(0, std::memory_order_relaxed);
     }
     return *this;
 }
@@ -80,17 +203,14 @@ DSString& DSString::operator=(const DSString& str) {
  * Creates new string with combined content
  */
 DSString DSString::operator+(const DSString& str) const {
-    char* newData = new char[length + str.length + 1];
+    DSString result;
+    result.allocate(length + str.length);
     for (size_t i = 0; i < length; i++) {
-        newData[i] = data[i];
+        result.data[i] = data[i];
     }
     for (size_t i = 0; i <= str.length; i++) {
-        newData[length + i] = str.data[i];
+        result.data[length + i] = str.data[i];
     }
-    DSString result;
-    delete[] result.data;
-    result.data = newData;
-    result.length = length + str.length;
     return result;
 }
 
@@ -140,6 +260,7 @@ char& DSString::operator[](size_t index) {
     if (index >= length) {
         throw std::out_of_range("Index out of bounds");
     }
+    cachedHash.store(0, std::memory_order_relaxed);
     return data[index];
 }
 
@@ -187,15 +308,7 @@ DSString DSString::substring(size_t start, size_t numChars) const {
         numChars = length - start;
     }
     
-    char* newStr = new char[numChars + 1];
-    for (size_t i = 0; i < numChars; i++) {
-        newStr[i] = data[start + i];
-    }
-    newStr[numChars] = '\0';
-    
-    DSString result(newStr);
-    delete[] newStr;
-    return result;
+    return DSString(data + start, numChars);
 }
 
 /**
@@ -207,4 +320,79 @@ DSString DSString::substring(size_t start, size_t numChars) const {
 std::ostream& operator<<(std::ostream& out, const DSString& str) {
     out << str.data;
     return out;
-} 
\ No newline at end of file
+} 
+
+/**
+ * @brief Views a null-terminated C-string
+ * @param str Source C-string (can be nullptr, giving an empty view)
+ */
+DSStringView::DSStringView(const char* str) : ptr(str ? str : ""), length(0) {
+    while (ptr[length] != '\0') length++;
+}
+
+/**
+ * @brief View of a sub-range
+ * @param start Starting position
+ * @param numChars Number of characters, clamped to the end of the view
+ * @return View of the sub-range (empty if start is out of range)
+ */
+DSStringView DSStringView::substring(size_t start, size_t numChars) const {
+    if (start >= length) {
+        return DSStringView();
+    }
+    if (start + numChars > length) {
+        numChars = length - start;
+    }
+    return DSStringView(ptr + start, numChars);
+}
+
+/**
+ * @brief Checks for a single character
+ * @param c Character to look for
+ * @return true if c occurs in the view
+ */
+bool DSStringView::contains(char c) const {
+    for (size_t i = 0; i < length; i++) {
+        if (ptr[i] == c) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Checks for a character sequence
+ * @param needle Sequence to look for
+ * @return true if needle occurs in the view (an empty needle always does)
+ */
+bool DSStringView::contains(DSStringView needle) const {
+    if (needle.length > length) return false;
+    for (size_t i = 0; i + needle.length <= length; i++) {
+        size_t j = 0;
+        while (j < needle.length && ptr[i + j] == needle.ptr[j]) j++;
+        if (j == needle.length) return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Content equality
+ * @param other View to compare with
+ * @return true if both views hold the same characters
+ */
+bool DSStringView::operator==(DSStringView other) const {
+    if (length != other.length) return false;
+    for (size_t i = 0; i < length; i++) {
+        if (ptr[i] != other.ptr[i]) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Stream output operator
+ * @param out Output stream
+ * @param str View to output
+ * @return Reference to output stream
+ */
+std::ostream& operator<<(std::ostream& out, DSStringView str) {
+    out.write(str.ptr, static_cast<std::streamsize>(str.length));
+    return out;
+}
\ No newline at end of file
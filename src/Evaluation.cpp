@@ -0,0 +1,295 @@
+#include "Evaluation.h"
+#include "Vocabulary.h"
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+
+const uint32_t NO_ROW = UINT32_MAX;
+const uint64_t NOT_NUMERIC = UINT64_MAX;
+
+// One parsed "sentiment,id" line
+struct Row {
+    const char* id;
+    uint32_t idLength;
+    int32_t label;
+    uint64_t hash;    // Of the id
+    uint64_t number;  // Value of a canonical decimal id, else NOT_NUMERIC
+
+    DSStringView idView() const { return DSStringView(id, idLength); }
+};
+
+int parseLabel(const CsvField& field, const CsvField& line) {
+    CsvField label = field.trimmed();
+    if (label.length != 1 || label.front() < '0' || label.front() >= '0' + EvaluationResult::NUM_LABELS) {
+        throw std::runtime_error("Invalid sentiment in line: " + line.str());
+    }
+    return label.front() - '0';
+}
+
+// Tweet ids are decimal numbers. When every id is written canonically (digits
+// only, no leading zero, at most 19 of them) equal values mean equal text, so
+// the join can compare one integer instead of chasing the id characters.
+uint64_t parseId(const CsvField& id) {
+    if (id.length == 0 || id.length > 19 || (id.front() == '0' && id.length > 1)) {
+        return NOT_NUMERIC;
+    }
+    uint64_t value = 0;
+    for (size_t i = 0; i < id.length; i++) {
+        char c = id.data[i];
+        if (c < '0' || c > '9') return NOT_NUMERIC;
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return value;
+}
+
+// Parses the lines of [begin, end) in parallel chunks, keeping file order
+std::vector<Row> parseRows(const char* begin, const char* end, ThreadPool& pool) {
+    std::vector<const char*> bounds = CsvReader::splitLines(begin, end, pool.size());
+    std::vector<std::vector<Row>> chunks(pool.size());
+    pool.parallelFor(chunks.size(), [&](size_t first, size_t last) {
+        for (size_t c = first; c < last; c++) {
+            CsvReader reader(bounds[c], bounds[c + 1]);
+            CsvField line;
+            while (reader.nextLine(line)) {
+                if (line.trimmed().empty()) continue;
+                CsvField fields[2];
+                CsvReader::splitFields(line, fields, 2);
+                CsvField id = fields[1].trimmed();
+                Row row;
+                row.id = id.data;
+                row.idLength = static_cast<uint32_t>(id.length);
+                row.label = parseLabel(fields[0], line);
+                row.hash = Vocabulary::hashWord(row.idView());
+                row.number = parseId(id);
+                chunks[c].push_back(row);
+            }
+        }
+    });
+
+    std::vector<Row> rows;
+    size_t count = 0;
+    for (const auto& chunk : chunks) count += chunk.size();
+    rows.reserve(count);
+    for (const auto& chunk : chunks) rows.insert(rows.end(), chunk.begin(), chunk.end());
+    if (rows.size() >= NO_ROW) {
+        throw std::runtime_error("Too many rows to evaluate");
+    }
+    return rows;
+}
+
+// Pairs every truth row of one hash partition with a prediction, writing match[]
+// Ids with several predictions keep them on a chain in file order; each truth
+// row with that id takes the next one.
+void joinPartition(const std::vector<Row>& truth, const std::vector<Row>& predictions,
+                   size_t partition, size_t numPartitions, bool numericIds,
+                   std::vector<uint32_t>& nextPrediction, std::vector<uint32_t>& match) {
+    struct Bucket {
+        uint64_t number = 0;       // Numeric id, or low hash bits to check before the text
+        uint32_t key = NO_ROW;     // A prediction row holding the id
+        uint32_t cursor = NO_ROW;  // Next unpaired prediction with the id
+    };
+
+    std::vector<uint32_t> predictionRows;
+    for (uint32_t i = 0; i < predictions.size(); i++) {
+        if (predictions[i].hash % numPartitions == partition) predictionRows.push_back(i);
+    }
+    std::vector<uint32_t> truthRows;
+    for (uint32_t t = 0; t < truth.size(); t++) {
+        if (truth[t].hash % numPartitions == partition) truthRows.push_back(t);
+    }
+
+    size_t capacity = 16;
+    while (capacity * 7 < predictionRows.size() * 10) capacity *= 2;
+    std::vector<Bucket> table(capacity);
+    size_t mask = capacity - 1;
+
+    // The upper hash bits pick the bucket; the partition used the remainder
+    auto home = [&](const Row& row) { return (row.hash >> 32) & mask; };
+    auto tag = [&](const Row& row) { return numericIds ? row.number : row.hash; };
+    auto find = [&](const Row& row) -> Bucket& {
+        size_t index = home(row);
+        uint64_t number = tag(row);
+        while (table[index].key != NO_ROW &&
+               !(table[index].number == number &&
+                 (numericIds || predictions[table[index].key].idView() == row.idView()))) {
+            index = (index + 1) & mask;
+        }
+        return table[index];
+    };
+
+    // The table is far larger than cache, so fetch buckets a few rows ahead
+    const size_t PREFETCH_DISTANCE = 8;
+
+    // Insert in reverse so that prepending leaves each chain in file order
+    for (size_t k = predictionRows.size(); k-- > 0;) {
+        if (k >= PREFETCH_DISTANCE) {
+            __builtin_prefetch(&table[home(predictions[predictionRows[k - PREFETCH_DISTANCE]])]);
+        }
+        uint32_t i = predictionRows[k];
+        Bucket& bucket = find(predictions[i]);
+        if (bucket.key == NO_ROW) {
+            bucket.number = tag(predictions[i]);
+        }
+        bucket.key = i;
+        nextPrediction[i] = bucket.cursor;
+        bucket.cursor = i;
+    }
+
+    for (size_t k = 0; k < truthRows.size(); k++) {
+        if (k + PREFETCH_DISTANCE < truthRows.size()) {
+            __builtin_prefetch(&table[home(truth[truthRows[k + PREFETCH_DISTANCE]])]);
+        }
+        uint32_t t = truthRows[k];
+        Bucket& bucket = find(truth[t]);
+        if (bucket.cursor != NO_ROW) {
+            match[t] = bucket.cursor;
+            bucket.cursor = nextPrediction[bucket.cursor];
+        }
+    }
+}
+
+} // namespace
+
+double EvaluationResult::accuracy() const {
+    return total ? static_cast<double>(correct) / total : 0.0;
+}
+
+bool EvaluationResult::hasLabel(int label) const {
+    for (int other = 0; other < NUM_LABELS; other++) {
+        if (confusion[label][other] || confusion[other][label]) return true;
+    }
+    return false;
+}
+
+double EvaluationResult::precision(int label) const {
+    uint64_t predicted = 0;
+    for (int actual = 0; actual < NUM_LABELS; actual++) predicted += confusion[actual][label];
+    return predicted ? static_cast<double>(confusion[label][label]) / predicted : 0.0;
+}
+
+double EvaluationResult::recall(int label) const {
+    uint64_t actual = 0;
+    for (int predicted = 0; predicted < NUM_LABELS; predicted++) actual += confusion[label][predicted];
+    return actual ? static_cast<double>(confusion[label][label]) / actual : 0.0;
+}
+
+double EvaluationResult::f1(int label) const {
+    double p = precision(label);
+    double r = recall(label);
+    return p + r > 0 ? 2 * p * r / (p + r) : 0.0;
+}
+
+EvaluationResult evaluate(const MappedFile& truthFile, const MappedFile& predictionsFile, ThreadPool& pool) {
+    // Skip header in truth file
+    CsvReader header(truthFile);
+    CsvField line;
+    header.nextLine(line);
+    const char* truthBegin = truthFile.data() + header.position(truthFile.data());
+
+    std::vector<Row> truth = parseRows(truthBegin, truthFile.data() + truthFile.size(), pool);
+    std::vector<Row> predictions = parseRows(predictionsFile.data(),
+                                             predictionsFile.data() + predictionsFile.size(), pool);
+
+    bool numericIds = true;
+    for (const auto* rows : {&truth, &predictions}) {
+        for (const Row& row : *rows) numericIds = numericIds && row.number != NOT_NUMERIC;
+    }
+
+    std::vector<uint32_t> match(truth.size(), NO_ROW);
+    std::vector<uint32_t> nextPrediction(predictions.size(), NO_ROW);
+    size_t numPartitions = pool.size();
+    pool.parallelFor(numPartitions, [&](size_t first, size_t last) {
+        for (size_t p = first; p < last; p++) {
+            joinPartition(truth, predictions, p, numPartitions, numericIds, nextPrediction, match);
+        }
+    });
+
+    // Tally contiguous ranges of truth rows; errors are stitched back in order
+    EvaluationResult result;
+    std::mutex mutex;
+    std::vector<std::pair<size_t, std::vector<EvaluationResult::Error>>> errorRanges;
+    pool.parallelFor(truth.size(), [&](size_t begin, size_t end) {
+        EvaluationResult local;
+        for (size_t t = begin; t < end; t++) {
+            if (match[t] == NO_ROW) {
+                local.missing++;
+                continue;
+            }
+            int actual = truth[t].label;
+            int predicted = predictions[match[t]].label;
+            local.confusion[actual][predicted]++;
+            local.total++;
+            if (actual == predicted) {
+                local.correct++;
+            } else {
+                local.errors.push_back({CsvField{truth[t].id, truth[t].idLength}, predicted, actual});
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        for (int a = 0; a < EvaluationResult::NUM_LABELS; a++) {
+            for (int p = 0; p < EvaluationResult::NUM_LABELS; p++) {
+                result.confusion[a][p] += local.confusion[a][p];
+            }
+        }
+        result.total += local.total;
+        result.correct += local.correct;
+        result.missing += local.missing;
+        errorRanges.emplace_back(begin, std::move(local.errors));
+    });
+
+    std::sort(errorRanges.begin(), errorRanges.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (auto& range : errorRanges) {
+        result.errors.insert(result.errors.end(), range.second.begin(), range.second.end());
+    }
+    return result;
+}
+
+void writeAccuracyReport(const EvaluationResult& result, std::ostream& out) {
+    out << std::fixed << std::setprecision(3) << result.accuracy() << '\n';
+    for (const auto& error : result.errors) {
+        out << error.predicted << ',' << error.actual << ',';
+        out.write(error.id.data, static_cast<std::streamsize>(error.id.length));
+        out << '\n';
+    }
+
+    std::vector<int> labels;
+    for (int label = 0; label < EvaluationResult::NUM_LABELS; label++) {
+        if (result.hasLabel(label)) labels.push_back(label);
+    }
+
+    out << "# evaluated," << result.total << '\n'
+        << "# correct," << result.correct << '\n'
+        << "# missing_predictions," << result.missing << '\n'
+        << "# confusion matrix: rows = actual, columns = predicted\n"
+        << "# actual\\predicted";
+    for (int label : labels) out << ',' << label;
+    out << '\n';
+    for (int actual : labels) {
+        out << "# " << actual;
+        for (int predicted : labels) out << ',' << result.confusion[actual][predicted];
+        out << '\n';
+    }
+
+    out << "# class,precision,recall,f1\n";
+    double precisionSum = 0;
+    double recallSum = 0;
+    double f1Sum = 0;
+    for (int label : labels) {
+        out << "# " << label << ',' << result.precision(label) << ',' << result.recall(label)
+            << ',' << result.f1(label) << '\n';
+        precisionSum += result.precision(label);
+        recallSum += result.recall(label);
+        f1Sum += result.f1(label);
+    }
+    if (!labels.empty()) {
+        double n = static_cast<double>(labels.size());
+        out << "# macro," << precisionSum / n << ',' << recallSum / n << ',' << f1Sum / n << '\n';
+    }
+}
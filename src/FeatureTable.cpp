@@ -0,0 +1,79 @@
+#include "FeatureTable.h"
+#include <cmath>
+#include <stdexcept>
+
+FeatureTable::FeatureTable(const FeatureTable& other) {
+    *this = other;
+}
+
+FeatureTable& FeatureTable::operator=(const FeatureTable& other) {
+    if (this != &other) {
+        // A copy always owns its counters, even if other is attached
+        owned.assign(other.countView, other.countView + other.size());
+        countView = owned.data();
+        mask = other.mask;
+        numBits = other.numBits;
+        attached = false;
+    }
+    return *this;
+}
+
+void FeatureTable::reset(unsigned bits) {
+    if (bits != 0 && (bits < MIN_BITS || bits > MAX_BITS)) {
+        throw std::runtime_error("Feature table bits must be between 10 and 30");
+    }
+    numBits = bits;
+    attached = false;
+    if (bits == 0) {
+        owned.clear();
+        owned.shrink_to_fit();
+        countView = nullptr;
+        mask = 0;
+        return;
+    }
+    owned.assign(size_t(1) << bits, WordCount{});
+    countView = owned.data();
+    mask = owned.size() - 1;
+}
+
+void FeatureTable::add(const FeatureTable& other, double factor) {
+    if (other.numBits != numBits) {
+        throw std::runtime_error("Feature tables differ in size");
+    }
+    makeWritable();
+    for (size_t i = 0; i < owned.size(); i++) {
+        const WordCount& count = other.countView[i];
+        if (factor == 1.0) {
+            owned[i].pos += count.pos;
+            owned[i].neg += count.neg;
+        } else {
+            owned[i].pos += static_cast<int32_t>(std::llround(count.pos * factor));
+            owned[i].neg += static_cast<int32_t>(std::llround(count.neg * factor));
+        }
+    }
+}
+
+void FeatureTable::scale(double factor) {
+    makeWritable();
+    for (WordCount& count : owned) {
+        count.pos = static_cast<int32_t>(std::llround(count.pos * factor));
+        count.neg = static_cast<int32_t>(std::llround(count.neg * factor));
+    }
+}
+
+void FeatureTable::attach(const WordCount* external, unsigned bits) {
+    owned.clear();
+    owned.shrink_to_fit();
+    countView = external;
+    numBits = bits;
+    mask = (size_t(1) << bits) - 1;
+    attached = true;
+}
+
+void FeatureTable::makeWritable() {
+    if (attached) {
+        owned.assign(countView, countView + size());
+        countView = owned.data();
+        attached = false;
+    }
+}
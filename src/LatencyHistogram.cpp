@@ -0,0 +1,70 @@
+#include "LatencyHistogram.h"
+
+int LatencyHistogram::bucketOf(uint64_t nanos) {
+    if (nanos < SUB_BUCKETS) {
+        return static_cast<int>(nanos);  // Exponents 0..2 are exact
+    }
+    int exponent = 63 - __builtin_clzll(nanos);
+    if (exponent > MAX_EXPONENT) {
+        return NUM_BUCKETS - 1;
+    }
+    // The three bits below the leading one pick the sub-bucket
+    int sub = static_cast<int>((nanos >> (exponent - 3)) & (SUB_BUCKETS - 1));
+    return (exponent - 2) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int bucket) {
+    if (bucket < SUB_BUCKETS) {
+        return static_cast<uint64_t>(bucket);
+    }
+    int exponent = bucket / SUB_BUCKETS + 2;
+    uint64_t sub = static_cast<uint64_t>(bucket % SUB_BUCKETS);
+    uint64_t step = uint64_t(1) << (exponent - 3);
+    return (uint64_t(1) << exponent) + (sub + 1) * step - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanos) {
+    buckets[bucketOf(nanos)]++;
+    total++;
+    sum += nanos;
+    if (nanos > largest) largest = nanos;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        buckets[i] += other.buckets[i];
+    }
+    total += other.total;
+    sum += other.sum;
+    if (other.largest > largest) largest = other.largest;
+}
+
+void LatencyHistogram::clear() {
+    buckets.fill(0);
+    total = 0;
+    sum = 0;
+    largest = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double q) const {
+    if (total == 0) return 0;
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            uint64_t bound = bucketUpperBound(i);
+            return bound < largest ? bound : largest;
+        }
+    }
+    return largest;
+}
+
+void LatencyHistogram::writeJson(std::ostream& out) const {
+    out << "{\"count\":" << total
+        << ",\"mean_ns\":" << static_cast<uint64_t>(mean())
+        << ",\"p50_ns\":" << percentile(0.50)
+        << ",\"p90_ns\":" << percentile(0.90)
+        << ",\"p99_ns\":" << percentile(0.99)
+        << ",\"max_ns\":" << largest << "}";
+}
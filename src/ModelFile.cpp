@@ -0,0 +1,166 @@
+#include "ModelFile.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+    const char MODEL_MAGIC[8] = {'S', 'N', 'T', 'M', 'O', 'D', 'E', 'L'};
+    const uint64_t SECTION_ALIGNMENT = 64;
+
+    uint64_t alignUp(uint64_t offset) {
+        return (offset + SECTION_ALIGNMENT - 1) & ~(SECTION_ALIGNMENT - 1);
+    }
+
+    // True if count items of size bytes from offset end at or before limit (without overflowing)
+    bool sectionFits(uint64_t offset, uint64_t count, uint64_t size, uint64_t limit) {
+        return offset <= limit && count <= (limit - offset) / size;
+    }
+
+    void writeSection(std::ofstream& out, uint64_t offset, const void* data, uint64_t bytes) {
+        static const char padding[SECTION_ALIGNMENT] = {};
+        uint64_t position = static_cast<uint64_t>(out.tellp());
+        out.write(padding, static_cast<std::streamsize>(offset - position));
+        if (bytes > 0) {
+            out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+        }
+    }
+}
+
+void saveModel(const Vocabulary& vocabulary, const char* path, const ModelInfo& info,
+               const FeatureTable* features) {
+    Vocabulary::Layout layout = vocabulary.layout();
+
+    ModelHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MODEL_MAGIC, sizeof(header.magic));
+    header.version = MODEL_FORMAT_VERSION;
+    header.byteOrder = MODEL_BYTE_ORDER;
+    header.numWords = layout.numWords;
+    header.numSlots = layout.numSlots;
+    header.arenaBytes = layout.arenaBytes;
+    header.slotsOffset = alignUp(sizeof(ModelHeader));
+    header.offsetsOffset = alignUp(header.slotsOffset + layout.numSlots * sizeof(Vocabulary::Slot));
+    header.lengthsOffset = alignUp(header.offsetsOffset + layout.numWords * sizeof(uint32_t));
+    header.countsOffset = alignUp(header.lengthsOffset + layout.numWords * sizeof(uint32_t));
+    header.arenaOffset = alignUp(header.countsOffset + layout.numWords * sizeof(WordCount));
+    header.fileSize = header.arenaOffset + layout.arenaBytes;
+    header.countScale = info.countScale;
+    uint64_t featureBytes = 0;
+    if (features && features->enabled()) {
+        featureBytes = features->size() * sizeof(WordCount);
+        header.featureBits = features->bits();
+        header.featuresOffset = alignUp(header.fileSize);
+        header.fileSize = header.featuresOffset + featureBytes;
+    }
+
+    std::string tempPath = std::string(path) + ".tmp";
+    std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        throw std::runtime_error("Unable to open model file for writing");
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeSection(out, header.slotsOffset, layout.slots, layout.numSlots * sizeof(Vocabulary::Slot));
+    writeSection(out, header.offsetsOffset, layout.offsets, layout.numWords * sizeof(uint32_t));
+    writeSection(out, header.lengthsOffset, layout.lengths, layout.numWords * sizeof(uint32_t));
+    writeSection(out, header.countsOffset, layout.counts, layout.numWords * sizeof(WordCount));
+    writeSection(out, header.arenaOffset, layout.arena, layout.arenaBytes);
+    if (featureBytes > 0) {
+        writeSection(out, header.featuresOffset, features->data(), featureBytes);
+    }
+    out.close();
+    if (!out || std::rename(tempPath.c_str(), path) != 0) {
+        std::remove(tempPath.c_str());
+        throw std::runtime_error("Unable to write model file");
+    }
+}
+
+void attachModel(const MappedFile& file, Vocabulary& vocabulary, ModelInfo* info, FeatureTable* features) {
+    if (file.size() < sizeof(ModelHeader)) {
+        throw std::runtime_error("Model file is truncated");
+    }
+    ModelHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+
+    if (std::memcmp(header.magic, MODEL_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("Not a sentiment model file");
+    }
+    if (header.byteOrder != MODEL_BYTE_ORDER) {
+        throw std::runtime_error("Model file was written with a different byte order");
+    }
+    if (header.version != MODEL_FORMAT_VERSION) {
+        throw std::runtime_error("Unsupported model file version");
+    }
+    if (!(header.countScale > 0 && header.countScale <= 1)) {
+        throw std::runtime_error("Model file is corrupt");
+    }
+    // Sections must be aligned, in order and inside the file
+    bool powerOfTwo = header.numSlots > 0 && (header.numSlots & (header.numSlots - 1)) == 0;
+    uint64_t misaligned = header.slotsOffset | header.offsetsOffset | header.lengthsOffset |
+                          header.countsOffset | header.arenaOffset;
+    if (header.fileSize != file.size() || !powerOfTwo || header.numWords >= header.numSlots ||
+        misaligned % SECTION_ALIGNMENT != 0 || header.slotsOffset < sizeof(ModelHeader) ||
+        !sectionFits(header.slotsOffset, header.numSlots, sizeof(Vocabulary::Slot), header.offsetsOffset) ||
+        !sectionFits(header.offsetsOffset, header.numWords, sizeof(uint32_t), header.lengthsOffset) ||
+        !sectionFits(header.lengthsOffset, header.numWords, sizeof(uint32_t), header.countsOffset) ||
+        !sectionFits(header.countsOffset, header.numWords, sizeof(WordCount), header.arenaOffset) ||
+        !sectionFits(header.arenaOffset, header.arenaBytes, 1, file.size())) {
+        throw std::runtime_error("Model file is corrupt");
+    }
+    if (header.featureBits != 0 &&
+        (header.featureBits < FeatureTable::MIN_BITS || header.featureBits > FeatureTable::MAX_BITS ||
+         header.featuresOffset % SECTION_ALIGNMENT != 0 ||
+         header.featuresOffset < header.arenaOffset + header.arenaBytes ||
+         !sectionFits(header.featuresOffset, uint64_t(1) << header.featureBits, sizeof(WordCount), file.size()))) {
+        throw std::runtime_error("Model file is corrupt");
+    }
+
+    const char* base = file.data();
+    Vocabulary::Layout layout;
+    layout.slots = reinterpret_cast<const Vocabulary::Slot*>(base + header.slotsOffset);
+    layout.numSlots = header.numSlots;
+    layout.offsets = reinterpret_cast<const uint32_t*>(base + header.offsetsOffset);
+    layout.lengths = reinterpret_cast<const uint32_t*>(base + header.lengthsOffset);
+    layout.counts = reinterpret_cast<const WordCount*>(base + header.countsOffset);
+    layout.numWords = header.numWords;
+    layout.arena = base + header.arenaOffset;
+    layout.arenaBytes = header.arenaBytes;
+
+    // Lookups follow slot ids and word extents without checks, so a file that
+    // may come from anywhere is checked once here (one pass over each array).
+    // Each word must own exactly one slot and the rest must be empty; probing
+    // stops only at an empty slot.
+    std::vector<bool> seen(layout.numWords);
+    uint64_t emptySlots = 0;
+    for (uint64_t slot = 0; slot < layout.numSlots; slot++) {
+        uint32_t id = layout.slots[slot].id;
+        if (id == Vocabulary::NOT_FOUND) {
+            emptySlots++;
+        } else if (id >= layout.numWords || seen[id]) {
+            throw std::runtime_error("Model file is corrupt");
+        } else {
+            seen[id] = true;
+        }
+    }
+    if (emptySlots != layout.numSlots - layout.numWords) {
+        throw std::runtime_error("Model file is corrupt");
+    }
+    for (uint64_t word = 0; word < layout.numWords; word++) {
+        if (!sectionFits(layout.offsets[word], layout.lengths[word], 1, layout.arenaBytes)) {
+            throw std::runtime_error("Model file is corrupt");
+        }
+    }
+    vocabulary.attach(layout);
+    if (info) {
+        info->countScale = header.countScale;
+    }
+    if (features) {
+        if (header.featureBits != 0) {
+            features->attach(reinterpret_cast<const WordCount*>(base + header.featuresOffset), header.featureBits);
+        } else {
+            features->reset(0);
+        }
+    }
+}
@@ -0,0 +1,59 @@
+#include "RunStats.h"
+#include <sys/resource.h>
+
+uint64_t peakRssBytes() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<uint64_t>(usage.ru_maxrss);  // Bytes
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024;  // Kilobytes
+#endif
+}
+
+void RunStats::addPhase(const char* name, uint64_t startNs, uint64_t endNs,
+                        uint64_t tweets, uint64_t bytes) {
+    PhaseStats phase;
+    phase.name = name;
+    phase.ms = (endNs - startNs) / 1e6;
+    phase.tweets = tweets;
+    phase.bytes = bytes;
+    phases.push_back(phase);
+}
+
+void RunStats::addThreadPhase(const char* name, uint64_t busyNs) {
+    PhaseStats phase;
+    phase.name = name;
+    phase.ms = busyNs / 1e6;
+    phase.summedOverThreads = true;
+    phases.push_back(phase);
+}
+
+void RunStats::writeJson(std::ostream& out) const {
+    out << "{\n  \"threads\": " << threads << ",\n  \"peak_rss_bytes\": " << peakRssBytes()
+        << ",\n  \"phases\": [";
+    for (size_t i = 0; i < phases.size(); i++) {
+        const PhaseStats& phase = phases[i];
+        out << (i ? ",\n" : "\n") << "    {\"name\": \"" << phase.name << "\", "
+            << (phase.summedOverThreads ? "\"thread_ms\": " : "\"wall_ms\": ") << phase.ms;
+        if (phase.tweets || phase.bytes) {
+            double seconds = phase.ms / 1e3;
+            out << ", \"tweets\": " << phase.tweets << ", \"bytes\": " << phase.bytes;
+            if (seconds > 0) {
+                out << ", \"tweets_per_s\": " << phase.tweets / seconds
+                    << ", \"mb_per_s\": " << phase.bytes / seconds / (1024.0 * 1024.0);
+            }
+        }
+        out << "}";
+    }
+    out << "\n  ],\n  \"vocabulary\": {\"words\": " << vocabulary.words
+        << ", \"slots\": " << vocabulary.slots
+        << ", \"heap_bytes\": " << vocabulary.heapBytes
+        << ", \"mapped_bytes\": " << vocabulary.mappedBytes
+        << ", \"score_table_bytes\": " << vocabulary.scoreTableBytes
+        << ", \"feature_bits\": " << vocabulary.featureBits
+        << ", \"feature_bytes\": " << vocabulary.featureBytes << "},\n"
+        << "  \"predict_latency\": ";
+    predictLatency.writeJson(out);
+    out << "\n}\n";
+}
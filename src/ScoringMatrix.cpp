@@ -0,0 +1,170 @@
+#include "ScoringMatrix.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define SCORING_X86 1
+#endif
+
+// The kernels address a weight's pos and neg as byte offsets of its column
+static_assert(sizeof(WordWeight) == 2 * sizeof(double), "WordWeight is two doubles");
+
+namespace {
+    // Sum of n strong indicator boosts, added one at a time like scoreTokens
+    inline double strongScore(uint32_t n, double boost) {
+        double score = 0;
+        for (uint32_t i = 0; i < n; i++) score += boost;
+        return score;
+    }
+
+    // The end of scoreTokens, once the clear word weights of row are summed
+    inline int decide(const ClassifierParams& params, const ScoringMatrix::Row& row,
+                      double positiveScore, double negativeScore, int64_t totalWords) {
+        if (totalWords > 0) {
+            positiveScore /= static_cast<int>(totalWords);
+            negativeScore /= static_cast<int>(totalWords);
+        }
+        if (row.strongPositive > 0 && !row.pendingNegation) {
+            positiveScore *= params.strongMultiplier;
+        }
+        if (row.strongNegative > 0 && !row.pendingNegation) {
+            negativeScore *= params.strongMultiplier;
+        }
+        for (uint32_t i = 0; i < row.smiles; i++) positiveScore += params.emoticonBoost;
+        for (uint32_t i = 0; i < row.frowns; i++) negativeScore += params.emoticonBoost;
+
+        double scoreDiff = positiveScore - negativeScore;
+        if (std::abs(scoreDiff) < params.confidence) {
+            if (row.strongPositive > 0) return 4;
+            if (row.strongNegative > 0) return 0;
+            return (positiveScore >= negativeScore) ? 4 : 0;
+        }
+        return (scoreDiff > 0) ? 4 : 0;
+    }
+
+    int scoreRow(const ScoringMatrix::Row& row, const uint32_t* begin, const uint32_t* end,
+                 const WordWeight* weights, const ClassifierParams& params) {
+        double positiveScore = strongScore(row.strongPositive, params.strongBoost);
+        double negativeScore = strongScore(row.strongNegative, params.strongBoost);
+        int64_t totalWords = 0;
+        for (const uint32_t* entry = begin; entry != end; entry++) {
+            const WordWeight& weight = weights[*entry >> 1];
+            bool negated = *entry & 1;
+            double posWeight = negated ? weight.neg : weight.pos;
+            double negWeight = negated ? weight.pos : weight.neg;
+            if (std::abs(posWeight - negWeight) > params.clarity) {
+                positiveScore += posWeight;
+                negativeScore += negWeight;
+                totalWords++;
+            }
+        }
+        return decide(params, row, positiveScore, negativeScore, totalWords);
+    }
+
+    void scoreRowsScalar(size_t numRows, const uint32_t* rowStart, const uint32_t* entries,
+                         const ScoringMatrix::Row* rows, const WordWeight* weights,
+                         const ClassifierParams& params, int* results) {
+        for (size_t r = 0; r < numRows; r++) {
+            results[r] = scoreRow(rows[r], entries + rowStart[r], entries + rowStart[r + 1], weights, params);
+        }
+    }
+
+#ifdef SCORING_X86
+    // Four rows per iteration, one per 64-bit lane. Step j gathers entry j of
+    // every row still that long, then its two weights, and adds the clear
+    // ones; a lane that is done or not clear adds +0.0, which leaves its sums
+    // exactly as the scalar loop has them.
+    __attribute__((target("avx2")))
+    void scoreRowsAvx2(size_t numRows, const uint32_t* rowStart, const uint32_t* entries,
+                       const ScoringMatrix::Row* rows, const WordWeight* weights,
+                       const ClassifierParams& params, int* results) {
+        const double* posBase = &weights[0].pos;
+        const double* negBase = &weights[0].neg;
+        const __m256d clarity = _mm256_set1_pd(params.clarity);
+        const __m256d signBit = _mm256_set1_pd(-0.0);
+        const __m128i negatedBit = _mm_set1_epi32(1);
+        size_t r = 0;
+        for (; r + 4 <= numRows; r += 4) {
+            // Entries are indexed from the first row's start, so 32-bit gather indices suffice
+            const int* base = reinterpret_cast<const int*>(entries + rowStart[r]);
+            __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rowStart + r));
+            __m128i last = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rowStart + r + 1));
+            __m128i start = _mm_sub_epi32(first, _mm_set1_epi32(static_cast<int>(rowStart[r])));
+            __m128i length = _mm_sub_epi32(last, first);
+            uint32_t longest = 0;
+            for (size_t lane = 0; lane < 4; lane++) {
+                longest = std::max(longest, rowStart[r + lane + 1] - rowStart[r + lane]);
+            }
+
+            __m256d pos = _mm256_setr_pd(
+                strongScore(rows[r].strongPositive, params.strongBoost),
+                strongScore(rows[r + 1].strongPositive, params.strongBoost),
+                strongScore(rows[r + 2].strongPositive, params.strongBoost),
+                strongScore(rows[r + 3].strongPositive, params.strongBoost));
+            __m256d neg = _mm256_setr_pd(
+                strongScore(rows[r].strongNegative, params.strongBoost),
+                strongScore(rows[r + 1].strongNegative, params.strongBoost),
+                strongScore(rows[r + 2].strongNegative, params.strongBoost),
+                strongScore(rows[r + 3].strongNegative, params.strongBoost));
+            __m256i count = _mm256_setzero_si256();
+
+            for (uint32_t j = 0; j < longest; j++) {
+                __m128i step = _mm_set1_epi32(static_cast<int>(j));
+                // Row lengths are below 2^31, so the signed compare is exact
+                __m128i active = _mm_cmpgt_epi32(length, step);
+                __m128i entry = _mm_mask_i32gather_epi32(_mm_setzero_si128(), base, _mm_add_epi32(start, step),
+                                                         active, 4);
+                __m256d activeLanes = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(active));
+                __m256d negated = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(
+                    _mm_cmpeq_epi32(_mm_and_si128(entry, negatedBit), negatedBit)));
+                // (column << 1) << 3 is the column's byte offset in weights
+                __m256i offset = _mm256_slli_epi64(_mm256_cvtepu32_epi64(_mm_andnot_si128(negatedBit, entry)), 3);
+                __m256d p = _mm256_mask_i64gather_pd(_mm256_setzero_pd(), posBase, offset, activeLanes, 1);
+                __m256d n = _mm256_mask_i64gather_pd(_mm256_setzero_pd(), negBase, offset, activeLanes, 1);
+                __m256d posWeight = _mm256_blendv_pd(p, n, negated);
+                __m256d negWeight = _mm256_blendv_pd(n, p, negated);
+                __m256d gap = _mm256_andnot_pd(signBit, _mm256_sub_pd(posWeight, negWeight));
+                __m256d clear = _mm256_and_pd(_mm256_cmp_pd(gap, clarity, _CMP_GT_OQ), activeLanes);
+                pos = _mm256_add_pd(pos, _mm256_and_pd(posWeight, clear));
+                neg = _mm256_add_pd(neg, _mm256_and_pd(negWeight, clear));
+                count = _mm256_sub_epi64(count, _mm256_castpd_si256(clear));
+            }
+
+            alignas(32) double posScores[4];
+            alignas(32) double negScores[4];
+            alignas(32) int64_t counts[4];
+            _mm256_store_pd(posScores, pos);
+            _mm256_store_pd(negScores, neg);
+            _mm256_store_si256(reinterpret_cast<__m256i*>(counts), count);
+            for (size_t lane = 0; lane < 4; lane++) {
+                results[r + lane] = decide(params, rows[r + lane], posScores[lane], negScores[lane], counts[lane]);
+            }
+        }
+        scoreRowsScalar(numRows - r, rowStart + r, entries, rows + r, weights, params, results + r);
+    }
+#endif
+}
+
+void ScoringMatrix::clear() {
+    rowStart.assign(1, 0);
+    entries.clear();
+    rows.clear();
+}
+
+size_t ScoringMatrix::memoryUsage() const {
+    return rowStart.capacity() * sizeof(uint32_t) + entries.capacity() * sizeof(uint32_t) +
+           rows.capacity() * sizeof(Row);
+}
+
+void ScoringMatrix::score(const WordWeight* weights, const ClassifierParams& params, int* results,
+                          Tokenizer::Isa isa) const {
+#ifdef SCORING_X86
+    if (isa == Tokenizer::Isa::AVX2 && Tokenizer::isSupported(isa)) {
+        scoreRowsAvx2(rows.size(), rowStart.data(), entries.data(), rows.data(), weights, params, results);
+        return;
+    }
+#endif
+    (void)isa;
+    scoreRowsScalar(rows.size(), rowStart.data(), entries.data(), rows.data(), weights, params, results);
+}
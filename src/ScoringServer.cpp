@@ -0,0 +1,263 @@
+#include "ScoringServer.h"
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <list>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <cerrno>
+#include <iostream>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+std::atomic<bool> ScoringServer::stopping(false);
+
+namespace {
+
+// Below this many requests a batch is scored inline on the connection thread;
+// handing it to the pool would cost more than it saves
+const size_t PARALLEL_BATCH = 256;
+const size_t READ_SIZE = 64 * 1024;
+// Longest request line a connection may send; the buffer grows to hold one
+const size_t MAX_LINE_BYTES = 1024 * 1024;
+// How often blocked loops wake up to check for stop()
+const int POLL_INTERVAL_MS = 200;
+
+// Waits until fd is readable; false if the server is stopping
+bool waitReadable(int fd, std::atomic<bool>& stopping) {
+    while (!stopping.load(std::memory_order_relaxed)) {
+        pollfd entry{fd, POLLIN, 0};
+        int ready = poll(&entry, 1, POLL_INTERVAL_MS);
+        if (ready > 0) return true;
+        if (ready < 0 && errno != EINTR) return false;
+    }
+    return false;
+}
+
+bool writeAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+void onSignal(int) {
+    ScoringServer::stop();
+}
+
+} // namespace
+
+ScoringServer::ScoringServer(const SentimentClassifier& classifier, unsigned threads)
+    : classifier(classifier), pool(threads) {
+    if (!classifier.isFrozen()) {
+        throw std::runtime_error("ScoringServer needs a frozen model");
+    }
+}
+
+void ScoringServer::stop() {
+    stopping.store(true);
+}
+
+void ScoringServer::installSignalHandlers() {
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = onSignal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    signal(SIGPIPE, SIG_IGN);
+}
+
+// Score texts into results, on the pool when the batch is large enough
+void ScoringServer::scoreBatch(const std::vector<CsvField>& texts, std::vector<int>& results) {
+    results.resize(texts.size());
+    auto body = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            results[i] = classifier.classify(DSStringView(texts[i].data, texts[i].length));
+        }
+    };
+    if (texts.size() < PARALLEL_BATCH || pool.size() == 1) {
+        body(0, texts.size());
+        return;
+    }
+    std::lock_guard<std::mutex> lock(poolMutex);
+    pool.parallelFor(texts.size(), body);
+}
+
+void ScoringServer::serveStream(int inFd, int outFd) {
+    std::vector<char> buffer(READ_SIZE);
+    size_t pending = 0;  // Bytes of an incomplete line kept from the last read
+    std::vector<CsvField> ids;
+    std::vector<CsvField> texts;
+    std::vector<int> results;
+    std::string response;
+    StreamStats stats;
+
+    bool more = true;
+    while (more) {
+        if (!waitReadable(inFd, stopping)) break;
+        if (pending == buffer.size()) {
+            if (buffer.size() >= MAX_LINE_BYTES) {
+                // A peer that never ends its line would otherwise grow the buffer without bound
+                std::string error = "error,request line longer than " + std::to_string(MAX_LINE_BYTES) + " bytes\n";
+                writeAll(outFd, error.data(), error.size());
+                break;
+            }
+            buffer.resize(buffer.size() * 2);  // A line longer than the buffer
+        }
+        ssize_t received = read(inFd, buffer.data() + pending, buffer.size() - pending);
+        if (received < 0) {
+            if (errno == EINTR || errno == EAGAIN) continue;
+            break;
+        }
+        uint64_t arrival = nowNanos();
+        size_t filled = pending + static_cast<size_t>(received);
+        // At end of input an unterminated last line is still a request
+        more = received > 0;
+        const char* end = buffer.data() + filled;
+        if (more) {
+            while (end > buffer.data() && end[-1] != '\n') end--;
+        }
+
+        // Every complete line in the buffer joins this batch
+        ids.clear();
+        texts.clear();
+        CsvReader reader(buffer.data(), end);
+        CsvField line;
+        while (reader.nextLine(line)) {
+            if (line.trimmed().empty()) continue;
+            // id, date, query, user, text (same layout as the test file)
+            CsvField fields[5];
+            CsvReader::splitFields(line, fields, 5);
+            if (fields[0].equals("id")) continue;  // Header row
+            ids.push_back(fields[0]);
+            texts.push_back(fields[4].unquoted());
+        }
+
+        if (!ids.empty()) {
+            scoreBatch(texts, results);
+            response.clear();
+            for (size_t i = 0; i < ids.size(); i++) {
+                response += static_cast<char>('0' + results[i]);
+                response += ',';
+                response.append(ids[i].data, ids[i].length);
+                response += '\n';
+            }
+            if (!writeAll(outFd, response.data(), response.size())) break;
+
+            uint64_t latency = nowNanos() - arrival;
+            for (size_t i = 0; i < ids.size(); i++) {
+                stats.latency.record(latency);
+            }
+            stats.batches++;
+        }
+
+        // Keep the partial line for the next read
+        pending = static_cast<size_t>(buffer.data() + filled - end);
+        std::memmove(buffer.data(), end, pending);
+    }
+
+    std::lock_guard<std::mutex> lock(statsMutex);
+    total.latency.merge(stats.latency);
+    total.batches += stats.batches;
+}
+
+void ScoringServer::serveSocket(const char* path) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (std::strlen(path) >= sizeof(address.sun_path)) {
+        throw std::runtime_error("Socket path too long");
+    }
+    std::strcpy(address.sun_path, path);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        throw std::runtime_error("Unable to create socket");
+    }
+    // Only a stale socket is replaced; any other file at path is left alone
+    struct stat existing;
+    if (lstat(path, &existing) == 0) {
+        if (!S_ISSOCK(existing.st_mode)) {
+            close(listener);
+            throw std::runtime_error(std::string(path) + " exists and is not a socket");
+        }
+        unlink(path);
+    }
+    if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 ||
+        listen(listener, SOMAXCONN) < 0) {
+        close(listener);
+        throw std::runtime_error("Unable to listen on socket");
+    }
+
+    struct Connection {
+        std::thread thread;
+        std::atomic<bool> finished{false};
+    };
+    std::list<Connection> connections;
+
+    int acceptError = 0;
+    while (waitReadable(listener, stopping)) {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            if (errno == EMFILE || errno == ENFILE || errno == ENOBUFS || errno == ENOMEM) {
+                // The listener stays readable; wait for connections to close rather than spin
+                std::this_thread::sleep_for(std::chrono::milliseconds(POLL_INTERVAL_MS));
+                continue;
+            }
+            acceptError = errno;
+            stop();
+            break;
+        }
+
+        // Reap connections that have closed
+        for (auto it = connections.begin(); it != connections.end();) {
+            if (it->finished) {
+                it->thread.join();
+                it = connections.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        connections.emplace_back();
+        Connection& connection = connections.back();
+        connection.thread = std::thread([this, client, &connection]() {
+            serveStream(client, client);
+            close(client);
+            report(std::cerr);
+            connection.finished = true;
+        });
+    }
+
+    // Connection threads notice stopping within one poll interval
+    for (auto& connection : connections) {
+        connection.thread.join();
+    }
+    close(listener);
+    unlink(path);
+    if (acceptError != 0) {
+        throw std::runtime_error(std::string("Unable to accept connections: ") + std::strerror(acceptError));
+    }
+}
+
+void ScoringServer::report(std::ostream& out) const {
+    std::lock_guard<std::mutex> lock(statsMutex);
+    const LatencyHistogram& latency = total.latency;
+    double meanBatch = total.batches ? static_cast<double>(latency.count()) / total.batches : 0.0;
+    out << "Served " << latency.count() << " requests in " << total.batches << " batches"
+        << " (mean batch " << meanBatch << "); latency p50 " << latency.percentile(0.50) / 1000.0
+        << " us, p99 " << latency.percentile(0.99) / 1000.0
+        << " us, max " << latency.max() / 1000.0 << " us" << std::endl;
+}
@@ -1,36 +1,92 @@
 #include "SentimentClassifier.h"
+#include "ThreadPool.h"
+#include "CsvReader.h"
+#include "ModelFile.h"
+#include "Lexicon.h"
+#include "Tokenizer.h"
+#include "Evaluation.h"
+#include "BoundedQueue.h"
+#include "Corpus.h"
+#include "ScoringMatrix.h"
+#include <atomic>
+#include <charconv>
+#include <exception>
 #include <fstream>
-#include <sstream>
 #include <iomanip>
 #include <iostream>
-#include <unordered_set>
 #include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <optional>
 #include <cctype>
+#include <thread>
+#include <cstdlib>
+#include <unistd.h>
+
+// Each thread reuses one tokenizer, so steady-state tokenization does not allocate
+static Tokenizer& threadTokenizer() {
+    static thread_local Tokenizer tokenizer;
+    return tokenizer;
+}
+
+// Adds the hashed unigram and bigram features of one tweet to table. A bigram
+// pairs a word with the previous word of the tweet and is counted with the
+// second word's weight and sentiment. wordOf(token, hash, weight, isPositive)
+// returns false for a token without a word, and otherwise sets the word's
+// hash and training weight, adjusting isPositive like wordWeight.
+template <typename TokenType, typename WordOf>
+static void countFeatures(const TokenType* begin, const TokenType* end, bool isPositive,
+                          FeatureTable& table, WordOf wordOf) {
+    uint64_t previous = 0;
+    bool hasPrevious = false;
+    for (const TokenType* token = begin; token != end; token++) {
+        uint64_t hash;
+        int weight;
+        bool positive = isPositive;
+        if (!wordOf(*token, hash, weight, positive)) continue;
+        int pos = positive ? weight : 0;
+        int neg = positive ? 0 : weight;
+        table.add(FeatureTable::unigram(hash), pos, neg);
+        if (hasPrevious) {
+            table.add(FeatureTable::bigram(previous, hash), pos, neg);
+        }
+        previous = hash;
+        hasPrevious = true;
+    }
+}
 
 // Tweet implementation
 Tweet::Tweet(const DSString& id, const DSString& text, int sentiment)
     : id(id), text(text), sentiment(sentiment) {}
 
 // Enhanced tokenization that preserves emoticons and handles punctuation better
-std::vector<DSString> SentimentClassifier::tokenize(const DSString& text) {
-    std::vector<DSString> tokens;
-    std::string str = text.c_str();
-    std::string current;
+// Reference form of the split; training and scoring use the fused Tokenizer,
+// which produces the same tokens together with preprocessWord's output.
+// Tokens are views into text; every token is a contiguous run of its characters.
+std::vector<DSStringView> SentimentClassifier::tokenize(DSStringView text) const {
+    std::vector<DSStringView> tokens;
+    const char* str = text.data();
+    size_t length = text.getLength();
+    size_t start = 0;  // First character of the word being collected
+    
+    auto flushWord = [&](size_t end) {
+        if (end > start) {
+            tokens.push_back(DSStringView(str + start, end - start));
+        }
+    };
     
-    for (size_t i = 0; i < str.length(); i++) {
+    for (size_t i = 0; i < length; i++) {
         char c = str[i];
         
         // Handle emoticons specially
         if (c == ':' || c == '=' || c == ';') {
-            if (i + 1 < str.length()) {
+            if (i + 1 < length) {
                 char next = str[i + 1];
                 if (next == ')' || next == '(' || next == 'D' || next == 'P') {
-                    if (!current.empty()) {
-                        tokens.push_back(DSString(current.c_str()));
-                        current.clear();
-                    }
-                    tokens.push_back(DSString(str.substr(i, 2).c_str()));
+                    flushWord(i);
+                    tokens.push_back(DSStringView(str + i, 2));
                     i++;
+                    start = i + 1;
                     continue;
                 }
             }
@@ -38,170 +94,671 @@ std::vector<DSString> SentimentClassifier::tokenize(const DSString& text) {
         
         // Handle special characters that might indicate sentiment
         if (c == '!' || c == '?' || c == '.') {
-            if (!current.empty()) {
-                tokens.push_back(DSString(current.c_str()));
-                current.clear();
-            }
+            flushWord(i);
             // Count multiple punctuation marks
-            std::string punct;
-            while (i < str.length() && (str[i] == '!' || str[i] == '?' || str[i] == '.')) {
-                punct += str[i];
-                i++;
+            size_t end = i;
+            while (end < length && (str[end] == '!' || str[end] == '?' || str[end] == '.')) {
+                end++;
             }
-            i--;
-            if (punct.length() > 1) {  // Multiple punctuation might indicate strong sentiment
-                tokens.push_back(DSString(punct.c_str()));
+            if (end - i > 1) {  // Multiple punctuation might indicate strong sentiment
+                tokens.push_back(DSStringView(str + i, end - i));
             }
+            i = end - 1;
+            start = end;
             continue;
         }
         
         if (c == ' ' || c == ',' || c == '\t' || c == '\n') {
-            if (!current.empty()) {
-                tokens.push_back(DSString(current.c_str()));
-                current.clear();
-            }
-        } else {
-            current += c;
+            flushWord(i);
+            start = i + 1;
         }
     }
     
-    if (!current.empty()) {
-        tokens.push_back(DSString(current.c_str()));
-    }
+    flushWord(length);
     
     return tokens;
 }
 
-// Enhanced stop words list with sentiment-aware filtering
-bool isStopWord(const std::string& word) {
-    static const std::unordered_set<std::string> stopWords = {
-        "the", "be", "to", "of", "and", "a", "in", "that", "have",
-        "i", "it", "for", "on", "with", "he", "as", "you",
-        "do", "at", "this", "but", "his", "by", "from", "they",
-        "we", "say", "her", "she", "or", "an", "will", "my",
-        "all", "would", "there", "their", "what", "so", "up", "out",
-        "if", "about", "who", "get", "which", "go", "me",
-        "when", "make", "can", "like", "time", "just", "him",
-        "take", "people", "into", "year", "your", "some"
-    };
-    
-    // Don't filter out negative words as they're important for sentiment
-    static const std::unordered_set<std::string> keepWords = {
-        "not", "no", "never", "none", "nothing", "nowhere", "neither",
-        "good", "bad", "great", "terrible", "awesome", "horrible"
-    };
-    
-    return stopWords.find(word) != stopWords.end() && keepWords.find(word) == keepWords.end();
+// Stop word check against the compiled lexicon (sentiment-bearing words are never stop words)
+bool isStopWord(DSStringView word) {
+    return (lexiconFlags(word) & LEX_STOP_WORD) != 0;
 }
 
 // Enhanced word preprocessing
-DSString SentimentClassifier::preprocessWord(const DSString& word) {
-    std::string processed;
-    std::string original = word.c_str();
-    
+DSString SentimentClassifier::preprocessWord(DSStringView word) const {
     // Preserve emoticons and multiple punctuation
-    if (original.length() <= 3 && 
-        (original.find(':') != std::string::npos || 
-         original.find('=') != std::string::npos ||
-         original.find('!') != std::string::npos)) {
-        return word;
+    if (word.getLength() <= 3 && 
+        (word.contains(':') || word.contains('=') || word.contains('!'))) {
+        return word.toString();
     }
     
     // Convert to lowercase and handle punctuation
-    for (char c : original) {
+    // Letters only, so the result is never longer than word; usual words fit on the stack
+    char stackBuffer[64];
+    std::vector<char> longBuffer;
+    char* processed = stackBuffer;
+    if (word.getLength() > sizeof(stackBuffer)) {
+        longBuffer.resize(word.getLength());
+        processed = longBuffer.data();
+    }
+    size_t processedLength = 0;
+    for (size_t i = 0; i < word.getLength(); i++) {
+        char c = word[i];
         if (std::isalpha(c)) {
-            processed += std::tolower(c);
+            processed[processedLength++] = static_cast<char>(std::tolower(c));
         }
     }
     
     // Skip stop words unless they're important for sentiment
-    if (processed.length() > 0 && !isStopWord(processed)) {
-        return DSString(processed.c_str());
+    if (processedLength > 0 && !isStopWord(DSStringView(processed, processedLength))) {
+        return DSString(processed, processedLength);
     }
     
-    return DSString("");
+    return DSString();
 }
 
 // Enhanced word frequency update with context awareness
 void SentimentClassifier::updateWordFrequency(const DSString& word, bool isPositive) {
-    int weight = 1;
-    std::string w = word.c_str();
-    
-    // Enhanced emoticon detection
-    if (w == ":)" || w == ":-)" || w == ":D" || w == "=)" || w == "<3" || 
-        w == ";)" || w == ";D" || w == ":-D" || w == "=D") {
-        weight = 4;
-        isPositive = true;
-    }
-    else if (w == ":(" || w == ":-(" || w == "=(" || w == ":'(" || 
-             w == ":/" || w == ":-/" || w == ":|" || w == ":-|") {
-        weight = 4;
-        isPositive = false;
-    }
-    // Strong positive sentiment words
-    else if (w == "love" || w == "awesome" || w == "excellent" || w == "amazing" ||
-             w == "fantastic" || w == "perfect" || w == "wonderful" || w == "great") {
-        weight = 3;
-    }
-    // Strong negative sentiment words
-    else if (w == "hate" || w == "terrible" || w == "awful" || w == "horrible" ||
-             w == "worst" || w == "sucks" || w == "disappointed" || w == "bad") {
-        weight = 3;
+    frozen = false;
+    updateWordFrequency(word, isPositive, vocabulary);
+}
+
+// Same as above, but accumulates into a caller-provided table
+void SentimentClassifier::updateWordFrequency(const DSString& word, bool isPositive, Vocabulary& counts) {
+    DSStringView w = word;
+    const LexiconEntry* entry = lookupLexicon(w);
+    int weight = wordWeight(params, entry ? entry->trainWeight : 1, entry ? entry->flags : 0,
+                            w.contains("!!!") || w.contains("???"), isPositive);
+    
+    // The string caches its hash, so re-counting a word does not rehash it
+    if (isPositive) {
+        counts.add(word, word.hash(), weight, 0);
+    } else {
+        counts.add(word, word.hash(), 0, weight);
+    }
+}
+
+// Token form used by training; the lexicon data was gathered by the tokenizer
+void SentimentClassifier::updateWordFrequency(const Token& token, bool isPositive, Vocabulary& counts) {
+    int weight = wordWeight(params, token.trainWeight, token.wordFlags,
+                            (token.marks & TOKEN_EMPHATIC) != 0, isPositive);
+    
+    if (isPositive) {
+        counts.add(token.word, weight, 0);
+    } else {
+        counts.add(token.word, 0, weight);
+    }
+}
+
+// Training weight of a word with context awareness; emoticons also decide the sentiment
+int SentimentClassifier::wordWeight(const ClassifierParams& params, uint8_t lexiconWeight, uint16_t flags,
+                                    bool emphatic, bool& isPositive) {
+    // Emoticons (4) and strong sentiment words (3) are marked by the lexicon
+    if (lexiconWeight > 1) {
+        if (flags & LEX_POSITIVE_EMOTICON) isPositive = true;
+        if (flags & LEX_NEGATIVE_EMOTICON) isPositive = false;
+        return flags & (LEX_POSITIVE_EMOTICON | LEX_NEGATIVE_EMOTICON) ? params.emoticonWeight
+                                                                      : params.strongWordWeight;
     }
     // Multiple punctuation indicates strong sentiment
-    else if (w.find("!!!") != std::string::npos || w.find("???") != std::string::npos) {
-        weight = 2;
+    if (emphatic) {
+        return params.emphaticWeight;
     }
+    return 1;
+}
+
+void SentimentClassifier::setFeatureHashing(unsigned bits) {
+    features.reset(bits);
+    vocabulary.clear();
+    modelMapping.close();
+    countScale = 1.0;
+    frozen = false;
+}
+
+void SentimentClassifier::setThreads(unsigned threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    numThreads = threads > 0 ? threads : 1;
+}
+
+// Train on a single CSV row
+// Timed adds the time spent on each step to times; otherwise times is untouched
+template <bool Timed>
+void SentimentClassifier::trainLine(const CsvField& line, CountTarget& target, TrainTimes& times) {
+    uint64_t start = Timed ? nowNanos() : 0;
     
-    if (isPositive) {
-        positiveWords[word] += weight;
+    // sentiment, id, date, query, user, text
+    CsvField fields[6];
+    CsvReader::splitFields(line, fields, 6);
+    
+    // Remove quotes if present
+    CsvField text = fields[5].unquoted();
+    
+    bool isPositive = fields[0].equals("4");
+    
+    uint64_t parsed = Timed ? nowNanos() : 0;
+    const std::vector<Token>& tokens = threadTokenizer().run(DSStringView(text.data, text.length));
+    uint64_t tokenized = Timed ? nowNanos() : 0;
+    
+    // Process each word
+    if (target.hashed.enabled()) {
+        countFeatures(tokens.data(), tokens.data() + tokens.size(), isPositive, target.hashed,
+                      [this](const Token& token, uint64_t& hash, int& weight, bool& positive) {
+            if (token.word.empty()) return false;
+            hash = Vocabulary::hashWord(token.word);
+            weight = wordWeight(params, token.trainWeight, token.wordFlags, (token.marks & TOKEN_EMPHATIC) != 0,
+                                positive);
+            return true;
+        });
+    } else if (target.sketch) {
+        for (const auto& token : tokens) {
+            if (token.word.empty()) continue;
+            if (admits(target, token.word, Vocabulary::hashWord(token.word))) {
+                updateWordFrequency(token, isPositive, target.counts);
+            } else {
+                target.droppedTokens++;
+            }
+        }
     } else {
-        negativeWords[word] += weight;
+        for (const auto& token : tokens) {
+            if (!token.word.empty()) {
+                updateWordFrequency(token, isPositive, target.counts);
+            }
+        }
+    }
+    
+    if (Timed) {
+        times.parseNs += parsed - start;
+        times.tokenizeNs += tokenized - parsed;
+        times.countNs += nowNanos() - tokenized;
+        times.tweets++;
     }
 }
 
-// Train the classifier
-void SentimentClassifier::train(const DSString& trainingFile) {
-    std::ifstream file(trainingFile.c_str());
+// Train on every line in [begin, end)
+template <bool Timed>
+void SentimentClassifier::trainShard(const char* begin, const char* end, CountTarget& target, TrainTimes& times) {
+    CsvReader reader(begin, end);
+    CsvField line;
+    while (reader.nextLine(line)) {
+        trainLine<Timed>(line, target, times);
+    }
+}
+
+// Count every row of a training file into target
+// With more than one thread the file is split into byte-range shards aligned to
+// line starts; each worker counts into its own tables, which are summed afterwards.
+// Counts are integer sums, so the merged model is identical to a serial run.
+// A training corpus (see Corpus.h) is counted from its stored tokens instead.
+void SentimentClassifier::countFile(const DSString& trainingFile, CountTarget& target) {
+    uint64_t start = stats ? nowNanos() : 0;
+    MappedFile file;
+    std::optional<Corpus> corpus = openCorpusOrCsv(trainingFile.c_str(), file);
     if (!file.is_open()) {
         throw std::runtime_error("Unable to open training file");
     }
+    if (corpus) {
+        countCorpus(*corpus, target, start, file.size());
+        return;
+    }
     
-    std::string line;
+    CsvReader reader(file);
+    CsvField line;
     // Skip header if exists
-    std::getline(file, line);
+    reader.nextLine(line);
+    const char* dataBegin = file.data() + reader.position(file.data());
+    const char* dataEnd = file.data() + file.size();
     
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string sentiment, id, date, query, user, text;
-        
-        // Parse CSV line
-        std::getline(ss, sentiment, ',');
-        std::getline(ss, id, ',');
-        std::getline(ss, date, ',');
-        std::getline(ss, query, ',');
-        std::getline(ss, user, ',');
-        std::getline(ss, text);
-        
-        // Remove quotes if present
-        if (text.front() == '"') text = text.substr(1);
-        if (text.back() == '"') text = text.substr(0, text.length() - 1);
+    unsigned numShards = numThreads > 0 ? numThreads : 1;
+    std::vector<TrainTimes> times(numShards);
+    auto runShard = [&](size_t i, const char* begin, const char* end, CountTarget& counts) {
+        if (stats) {
+            trainShard<true>(begin, end, counts, times[i]);
+        } else {
+            trainShard<false>(begin, end, counts, times[i]);
+        }
+    };
+    
+    uint64_t counted = 0;
+    uint64_t merged = 0;
+    if (numThreads <= 1) {
+        runShard(0, dataBegin, dataEnd, target);
+        counted = merged = stats ? nowNanos() : 0;
+    } else {
+        std::vector<const char*> bounds = CsvReader::splitLines(dataBegin, dataEnd, numThreads);
         
-        bool isPositive = (sentiment == "4");
+        std::vector<Vocabulary> shards(numThreads);
+        std::vector<FeatureTable> hashedShards(numThreads, FeatureTable(target.hashed.bits()));
+        std::vector<CountTarget> shardTargets;
+        for (unsigned i = 0; i < numThreads; i++) {
+            shardTargets.push_back(CountTarget{shards[i], hashedShards[i], target.sketch, 0});
+        }
+        ThreadPool pool(numThreads);
+        pool.parallelFor(numThreads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                runShard(i, bounds[i], bounds[i + 1], shardTargets[i]);
+            }
+        });
         
-        // Tokenize and process each word
-        auto tokens = tokenize(DSString(text.c_str()));
-        for (const auto& token : tokens) {
-            DSString processedWord = preprocessWord(token);
-            if (processedWord.getLength() > 0) {
-                updateWordFrequency(processedWord, isPositive);
+        // Merge thread-local tables into the model in file order, so words also
+        // receive the same ids as in a serial run
+        counted = stats ? nowNanos() : 0;
+        for (const auto& shard : shardTargets) {
+            target.counts.merge(shard.counts);
+            target.hashed.add(shard.hashed);
+            target.droppedTokens += shard.droppedTokens;
+        }
+        merged = stats ? nowNanos() : 0;
+    }
+    
+    if (stats) {
+        TrainTimes total;
+        for (const auto& shard : times) {
+            total.parseNs += shard.parseNs;
+            total.tokenizeNs += shard.tokenizeNs;
+            total.countNs += shard.countNs;
+            total.tweets += shard.tweets;
+        }
+        stats->addPhase("train", start, merged, total.tweets, file.size());
+        stats->addThreadPhase("train.parse", total.parseNs);
+        stats->addThreadPhase("train.tokenize", total.tokenizeNs);
+        stats->addThreadPhase("train.count", total.countNs);
+        stats->addPhase("train.merge", counted, merged);
+    }
+}
+
+// Count every tweet of a training corpus into target
+// Each shard of tweets sums its weights into dense per-dictionary-word
+// arrays; the sums are then added in dictionary order, which is the order
+// the words were first seen in the CSV, so the result matches countFile.
+// Hashed features are counted per shard and summed, which is exact as well.
+void SentimentClassifier::countCorpus(const Corpus& corpus, CountTarget& target, uint64_t start, uint64_t bytes) {
+    if (corpus.kind() != CorpusKind::Training) {
+        throw std::runtime_error("Training needs a training corpus");
+    }
+    
+    FeatureTable& hashedTarget = target.hashed;
+    bool hashed = hashedTarget.enabled();
+    size_t numShards = std::max<size_t>(1, std::min<size_t>(numThreads, corpus.size()));
+    std::vector<std::vector<WordCount>> shards(numShards, std::vector<WordCount>(hashed ? 0 : corpus.numWords()));
+    // Shard 0 counts features straight into hashedTarget
+    std::vector<FeatureTable> hashedShards(hashed ? numShards - 1 : 0, FeatureTable(hashedTarget.bits()));
+    std::vector<uint64_t> wordHashes(hashed ? corpus.numWords() : 0);
+    for (uint32_t word = 0; word < wordHashes.size(); word++) {
+        wordHashes[word] = Vocabulary::hashWord(corpus.word(word));
+    }
+    // With a sketch, admission is decided once per dictionary word
+    std::vector<uint8_t> admitted(target.sketch && !hashed ? corpus.numWords() : 0);
+    for (uint32_t word = 0; word < admitted.size(); word++) {
+        DSStringView text = corpus.word(word);
+        admitted[word] = admits(target, text, Vocabulary::hashWord(text));
+    }
+    std::vector<uint64_t> droppedTokens(numShards, 0);
+    auto hashedWord = [&](const CorpusToken& token, uint64_t& hash, int& weight, bool& positive) {
+        if (token.word == CORPUS_NO_WORD) return false;
+        const CorpusWord& info = corpus.wordInfo(token.word);
+        hash = wordHashes[token.word];
+        weight = wordWeight(params, info.trainWeight, info.flags, (token.marks & TOKEN_EMPHATIC) != 0, positive);
+        return true;
+    };
+    std::vector<uint64_t> countNs(numShards, 0);
+    ThreadPool pool(numThreads);
+    pool.parallelFor(numShards, [&](size_t begin, size_t end) {
+        for (size_t shard = begin; shard < end; shard++) {
+            uint64_t shardStart = stats ? nowNanos() : 0;
+            std::vector<WordCount>& counts = shards[shard];
+            size_t first = corpus.size() * shard / numShards;
+            size_t last = corpus.size() * (shard + 1) / numShards;
+            if (hashed) {
+                FeatureTable& table = shard == 0 ? hashedTarget : hashedShards[shard - 1];
+                for (size_t tweet = first; tweet < last; tweet++) {
+                    countFeatures(corpus.tokensBegin(tweet), corpus.tokensEnd(tweet), corpus.label(tweet) == 4,
+                                  table, hashedWord);
+                }
+            } else {
+                for (size_t tweet = first; tweet < last; tweet++) {
+                    bool positive = corpus.label(tweet) == 4;
+                    for (const CorpusToken* token = corpus.tokensBegin(tweet); token != corpus.tokensEnd(tweet); token++) {
+                        if (token->word == CORPUS_NO_WORD) continue;
+                        if (!admitted.empty() && !admitted[token->word]) {
+                            droppedTokens[shard]++;
+                            continue;
+                        }
+                        const CorpusWord& info = corpus.wordInfo(token->word);
+                        bool isPositive = positive;
+                        int weight = wordWeight(params, info.trainWeight, info.flags,
+                                                (token->marks & TOKEN_EMPHATIC) != 0, isPositive);
+                        if (isPositive) {
+                            counts[token->word].pos += weight;
+                        } else {
+                            counts[token->word].neg += weight;
+                        }
+                    }
+                }
+            }
+            if (stats) countNs[shard] = nowNanos() - shardStart;
+        }
+    });
+    
+    uint64_t counted = stats ? nowNanos() : 0;
+    for (const FeatureTable& shard : hashedShards) {
+        hashedTarget.add(shard);
+    }
+    std::vector<WordCount>& total = shards[0];
+    for (size_t shard = 1; shard < numShards; shard++) {
+        for (size_t word = 0; word < total.size(); word++) {
+            total[word].pos += shards[shard][word].pos;
+            total[word].neg += shards[shard][word].neg;
+        }
+    }
+    for (uint32_t word = 0; word < total.size(); word++) {
+        if (admitted.empty() || admitted[word]) {
+            target.counts.add(corpus.word(word), total[word].pos, total[word].neg);
+        }
+    }
+    for (uint64_t dropped : droppedTokens) {
+        target.droppedTokens += dropped;
+    }
+    
+    if (stats) {
+        uint64_t merged = nowNanos();
+        uint64_t busyNs = 0;
+        for (uint64_t ns : countNs) busyNs += ns;
+        stats->addPhase("train", start, merged, corpus.size(), bytes);
+        stats->addThreadPhase("train.count", busyNs);
+        stats->addPhase("train.merge", counted, merged);
+    }
+}
+
+// First pass of pruned training: occurrences of every word of a training
+// file, in a sketch. Shards sketch separately and merge exactly; a corpus
+// counts per dictionary word and adds each total once.
+CountMinSketch SentimentClassifier::sketchFile(const DSString& trainingFile) {
+    uint64_t start = stats ? nowNanos() : 0;
+    CountMinSketch sketch(pruning.sketchBits);
+    MappedFile file;
+    std::optional<Corpus> input = openCorpusOrCsv(trainingFile.c_str(), file);
+    if (!file.is_open()) {
+        throw std::runtime_error("Unable to open training file");
+    }
+    if (input) {
+        const Corpus& corpus = *input;
+        std::vector<uint32_t> occurrences(corpus.numWords(), 0);
+        for (size_t tweet = 0; tweet < corpus.size(); tweet++) {
+            for (const CorpusToken* token = corpus.tokensBegin(tweet); token != corpus.tokensEnd(tweet); token++) {
+                if (token->word != CORPUS_NO_WORD) occurrences[token->word]++;
+            }
+        }
+        for (uint32_t word = 0; word < occurrences.size(); word++) {
+            sketch.add(Vocabulary::hashWord(corpus.word(word)), occurrences[word]);
+        }
+    } else {
+        CsvReader reader(file);
+        CsvField line;
+        reader.nextLine(line);  // Header
+        const char* dataBegin = file.data() + reader.position(file.data());
+        std::vector<const char*> bounds = CsvReader::splitLines(dataBegin, file.data() + file.size(), numThreads);
+        std::vector<CountMinSketch> shards(bounds.size() - 2, CountMinSketch(pruning.sketchBits));
+        ThreadPool pool(numThreads);
+        pool.parallelFor(bounds.size() - 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                CountMinSketch& shard = i == 0 ? sketch : shards[i - 1];
+                CsvReader lines(bounds[i], bounds[i + 1]);
+                CsvField row;
+                while (lines.nextLine(row)) {
+                    CsvField fields[6];
+                    CsvReader::splitFields(row, fields, 6);
+                    CsvField text = fields[5].unquoted();
+                    for (const Token& token : threadTokenizer().run(DSStringView(text.data, text.length))) {
+                        if (!token.word.empty()) shard.add(Vocabulary::hashWord(token.word));
+                    }
+                }
+            }
+        });
+        for (const CountMinSketch& shard : shards) {
+            sketch.merge(shard);
+        }
+    }
+    if (stats) stats->addPhase("train.sketch", start, nowNanos(), 0, file.size());
+    return sketch;
+}
+
+// Keep the maxWords words with the highest total counts (ties: first seen)
+// The survivors are re-added in id order, so they keep their relative order.
+void SentimentClassifier::trimVocabulary(size_t maxWords) {
+    uint64_t start = stats ? nowNanos() : 0;
+    const Vocabulary& model = vocabulary;
+    std::vector<uint32_t> ids(model.size());
+    for (uint32_t id = 0; id < ids.size(); id++) ids[id] = id;
+    auto total = [&model](uint32_t id) {
+        return static_cast<int64_t>(model.counts(id).pos) + model.counts(id).neg;
+    };
+    std::nth_element(ids.begin(), ids.begin() + maxWords, ids.end(), [&](uint32_t a, uint32_t b) {
+        return total(a) != total(b) ? total(a) > total(b) : a < b;
+    });
+    std::vector<uint8_t> keep(model.size(), 0);
+    for (size_t i = 0; i < maxWords; i++) keep[ids[i]] = 1;
+    
+    Vocabulary kept;
+    for (uint32_t id = 0; id < model.size(); id++) {
+        if (keep[id]) kept.add(model.word(id), model.counts(id).pos, model.counts(id).neg);
+    }
+    pruneReport.trimmedWords = model.size() - kept.size();
+    vocabulary.swap(kept);
+    if (stats) stats->addPhase("train.trim", start, nowNanos());
+}
+
+// Train the classifier, adding the file's counts to the current model
+// With pruning on (see setPruning), a sketch pass over the file comes first
+// and the vocabulary is trimmed to maxWords afterwards.
+void SentimentClassifier::train(const DSString& trainingFile) {
+    frozen = false;
+    bool prune = isPruning();
+    if (prune && features.enabled()) {
+        throw std::runtime_error("Pruning does not apply to feature hashing");
+    }
+    if (pruning.minCount > CountMinSketch::MAX_COUNT) {
+        throw std::runtime_error("Minimum count must be at most 255");
+    }
+    pruneReport = PruneReport();
+    std::optional<CountMinSketch> sketch;
+    if (prune && pruning.minCount > 1) {
+        sketch.emplace(sketchFile(trainingFile));
+    }
+    const CountMinSketch* admission = sketch ? &*sketch : nullptr;
+    
+    if (countScale == 1.0) {
+        CountTarget target{vocabulary, features, admission, 0};
+        countFile(trainingFile, target);
+        pruneReport.droppedTokens = target.droppedTokens;
+    } else {
+        // Stored counts are in decayed units; scale the new counts to match
+        Vocabulary batch;
+        FeatureTable hashedBatch(features.bits());
+        CountTarget target{batch, hashedBatch, admission, 0};
+        countFile(trainingFile, target);
+        pruneReport.droppedTokens = target.droppedTokens;
+        uint64_t start = stats ? nowNanos() : 0;
+        double factor = 1.0 / countScale;
+        features.add(hashedBatch, factor);
+        const Vocabulary& counted = batch;
+        for (uint32_t id = 0; id < counted.size(); id++) {
+            const WordCount& count = counted.counts(id);
+            vocabulary.add(counted.word(id), static_cast<int>(std::llround(count.pos * factor)),
+                           static_cast<int>(std::llround(count.neg * factor)));
+        }
+        if (stats) stats->addPhase("train.fold", start, nowNanos());
+    }
+    
+    if (prune) {
+        if (pruning.maxWords > 0 && vocabulary.size() > pruning.maxWords) {
+            trimVocabulary(pruning.maxWords);
+        }
+        pruneReport.words = vocabulary.size();
+        pruneReport.modelBytes = vocabulary.memoryUsage();
+        pruneReport.sketchBytes = sketch ? sketch->memoryUsage() : 0;
+    }
+    if (stats) recordVocabularyStats();
+}
+
+// Fold a new labeled batch into the model, first decaying the existing counts
+// Decay only lowers countScale; the stored counts are rewritten once every
+// log(MIN_COUNT_SCALE) / log(decay) updates, so the amortized cost stays
+// proportional to the batch rather than the vocabulary.
+void SentimentClassifier::update(const DSString& batchFile, double decay) {
+    if (!(decay > 0 && decay <= 1)) {
+        throw std::runtime_error("Decay must be in (0, 1]");
+    }
+    if (decay < 1) {
+        countScale *= decay;
+        if (countScale < MIN_COUNT_SCALE) {
+            rescaleCounts();
+        }
+    }
+    train(batchFile);
+}
+
+// Apply countScale to every stored count and reset it to 1
+void SentimentClassifier::rescaleCounts() {
+    uint64_t start = stats ? nowNanos() : 0;
+    for (uint32_t id = 0; id < vocabulary.size(); id++) {
+        WordCount& count = vocabulary.counts(id);
+        count.pos = static_cast<int32_t>(std::llround(count.pos * countScale));
+        count.neg = static_cast<int32_t>(std::llround(count.neg * countScale));
+    }
+    if (features.enabled()) {
+        features.scale(countScale);
+    }
+    countScale = 1.0;
+    if (stats) stats->addPhase("rescale", start, nowNanos());
+}
+
+// Persist the trained counts
+void SentimentClassifier::saveModel(const DSString& modelFile) const {
+    uint64_t start = stats ? nowNanos() : 0;
+    ModelInfo info;
+    info.countScale = countScale;
+    ::saveModel(vocabulary, modelFile.c_str(), info, &features);
+    if (stats) stats->addPhase("save_model", start, nowNanos());
+}
+
+// Map a saved model and score straight from it
+void SentimentClassifier::loadModel(const DSString& modelFile) {
+    frozen = false;
+    uint64_t start = stats ? nowNanos() : 0;
+    vocabulary.clear();
+    if (!modelMapping.open(modelFile.c_str(), false)) {
+        throw std::runtime_error("Unable to open model file");
+    }
+    ModelInfo info;
+    attachModel(modelMapping, vocabulary, &info, &features);
+    countScale = info.countScale;
+    if (stats) {
+        stats->addPhase("load_model", start, nowNanos(), 0, modelMapping.size());
+        recordVocabularyStats();
+    }
+}
+
+// Record the current model size in stats
+void SentimentClassifier::recordVocabularyStats() {
+    VocabularyStats& model = stats->vocabulary;
+    model.words = vocabulary.size();
+    model.slots = vocabulary.layout().numSlots;
+    model.heapBytes = vocabulary.memoryUsage() + features.memoryUsage();
+    model.mappedBytes = vocabulary.isAttached() || features.isAttached() ? modelMapping.size() : 0;
+    model.scoreTableBytes = frozen ? wordWeights.capacity() * sizeof(WordWeight) : 0;
+    model.featureBits = features.bits();
+    model.featureBytes = features.size() * sizeof(WordCount);
+}
+
+// Build the read-only scoring table from the current counts
+void SentimentClassifier::freeze() {
+    uint64_t start = stats ? nowNanos() : 0;
+    // Read through a const reference so a mapped model is not copied
+    const Vocabulary& model = vocabulary;
+    wordWeights.resize(model.size() + 1);
+    for (uint32_t id = 0; id < model.size(); id++) {
+        wordWeights[id] = weightOf(model.counts(id), countScale);
+    }
+    wordWeights.back() = WordWeight{0, 0};  // Unseen words in a ScoringMatrix
+    // Hashed features have no per-word table; scoring weighs their counters directly
+    frozen = true;
+    if (stats) {
+        stats->addPhase("freeze", start, nowNanos(), 0, 0);
+        recordVocabularyStats();
+    }
+}
+
+// Scoring weights of a count stored at the given scale
+WordWeight SentimentClassifier::weightOf(const WordCount& count, double scale) {
+    // Effective counts; with scale 1 these are the integer counts exactly
+    double pos = count.pos * scale;
+    double neg = count.neg * scale;
+    return WordWeight{pos / (pos + neg + 1), neg / (pos + neg + 1)};
+}
+
+// Weights of a word in feature-hashing mode, given its hash and the previous
+// word's (nullptr at the start of a tweet). The bigram is used when it was
+// seen at least MIN_BIGRAM_COUNT times and leans clearly one way; otherwise
+// the word's own unigram counts are.
+SentimentClassifier::FeatureKind SentimentClassifier::hashedWeights(const uint64_t* previousHash, uint64_t hash,
+                                                                    WordWeight& weight) const {
+    if (previousHash) {
+        const WordCount& count = features.counts(FeatureTable::bigram(*previousHash, hash));
+        if ((static_cast<double>(count.pos) + count.neg) * countScale >= MIN_BIGRAM_COUNT) {
+            weight = weightOf(count, countScale);
+            if (std::abs(weight.pos - weight.neg) > params.clarity) {
+                return FEATURE_BIGRAM;
             }
         }
     }
+    weight = weightOf(features.counts(FeatureTable::unigram(hash)), countScale);
+    return FEATURE_WORD;
 }
 
-// Enhanced sentiment prediction
-int SentimentClassifier::predictSentiment(const DSString& text) {
+// Score a single tweet for callers outside the batch predict()
+int SentimentClassifier::classify(DSStringView text) const {
+    if (!frozen) {
+        throw std::runtime_error("Model must be frozen before scoring");
+    }
+    return predictSentiment(text);
+}
+
+// Batch scoring: each text becomes a matrix row of vocabulary ids
+void SentimentClassifier::classifyBatch(const DSStringView* texts, size_t count, int* results,
+                                        ScoringMatrix& matrix, Tokenizer::Isa isa) const {
+    if (!frozen) {
+        throw std::runtime_error("Model must be frozen before scoring");
+    }
+    if (features.enabled()) {
+        for (size_t i = 0; i < count; i++) {
+            results[i] = predictSentiment(texts[i]);
+        }
+        return;
+    }
+    const uint32_t unseen = static_cast<uint32_t>(vocabulary.size());
+    matrix.clear();
+    for (size_t i = 0; i < count; i++) {
+        const std::vector<Token>& tokens = threadTokenizer().run(texts[i]);
+        matrix.addRow(tokens.data(), tokens.data() + tokens.size(), [&](const Token& token) {
+            if (token.word.empty()) return ScoringMatrix::NO_COLUMN;
+            uint32_t id = vocabulary.find(token.word);
+            return id != Vocabulary::NOT_FOUND ? id : unseen;
+        });
+    }
+    matrix.score(wordWeights.data(), params, results, isa);
+}
+
+// Enhanced sentiment prediction over the token records of one tweet
+// Shared by text and corpus scoring: wordOf(token, weight) is called once per
+// token, in order, and returns FEATURE_NONE for a token without a normalized
+// word; otherwise it sets the word's weights (0 if unseen) and says whether
+// they came from a bigram, which already accounts for a negation before the
+// word. The thresholds and boosts come from params.
+template <typename TokenType, typename WordOf>
+int SentimentClassifier::scoreTokens(const ClassifierParams& params, const TokenType* begin, const TokenType* end,
+                                     WordOf wordOf) {
     double positiveScore = 0;
     double negativeScore = 0;
     int totalWords = 0;
@@ -209,56 +766,47 @@ int SentimentClassifier::predictSentiment(const DSString& text) {
     bool hasStrongPositive = false;
     bool hasStrongNegative = false;
     
-    auto tokens = tokenize(text);
-    
     // First pass: check for strong indicators
-    for (const auto& token : tokens) {
-        std::string word = token.c_str();
-        std::transform(word.begin(), word.end(), word.begin(), ::tolower);
-        
+    for (const TokenType* token = begin; token != end; token++) {
         // Very strong positive indicators (reduced list to most reliable ones)
-        if (word == "love" || word == "awesome" || word == "amazing" ||
-            word == "thank" || word == "thanks" || word == "best") {
+        if (token->rawFlags & LEX_SCORE_POSITIVE) {
             hasStrongPositive = true;
-            positiveScore += 0.8;  // Increased direct boost
+            positiveScore += params.strongBoost;  // Increased direct boost
         }
         
         // Very strong negative indicators (reduced list to most reliable ones)
-        if (word == "hate" || word == "terrible" || word == "worst" ||
-            word == "sucks" || word == "horrible") {
+        if (token->rawFlags & LEX_SCORE_NEGATIVE) {
             hasStrongNegative = true;
-            negativeScore += 0.8;  // Increased direct boost
+            negativeScore += params.strongBoost;  // Increased direct boost
         }
     }
     
     // Second pass: detailed analysis
-    for (size_t i = 0; i < tokens.size(); i++) {
-        DSString processedWord = preprocessWord(tokens[i]);
-        std::string word = tokens[i].c_str();
-        std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+    for (const TokenType* token = begin; token != end; token++) {
+        // Every token is looked up, so a hashed bigram sees a negation as its first word
+        WordWeight weight{0, 0};
+        FeatureKind feature = wordOf(*token, weight);
         
         // Core negation words only
-        if (word == "not" || word == "no" || word == "never" || 
-            word == "don't" || word == "doesn't" || word == "didn't") {
+        if (token->rawFlags & LEX_NEGATION) {
             hasNegation = true;
             continue;
         }
         
-        if (processedWord.getLength() > 0) {
-            // Calculate word weights with context
-            double posWeight = static_cast<double>(positiveWords[processedWord]) / 
-                             (positiveWords[processedWord] + negativeWords[processedWord] + 1);
-            double negWeight = static_cast<double>(negativeWords[processedWord]) / 
-                             (positiveWords[processedWord] + negativeWords[processedWord] + 1);
+        if (feature != FEATURE_NONE) {
+            double posWeight = weight.pos;
+            double negWeight = weight.neg;
             
             // Apply negation
             if (hasNegation) {
-                std::swap(posWeight, negWeight);
+                if (feature == FEATURE_WORD) {
+                    std::swap(posWeight, negWeight);
+                }
                 hasNegation = false;
             }
             
             // Only count words with clear sentiment
-            if (std::abs(posWeight - negWeight) > 0.2) {  // Increased threshold for more confidence
+            if (std::abs(posWeight - negWeight) > params.clarity) {  // Increased threshold for more confidence
                 positiveScore += posWeight;
                 negativeScore += negWeight;
                 totalWords++;
@@ -274,28 +822,26 @@ int SentimentClassifier::predictSentiment(const DSString& text) {
     
     // Apply strong sentiment multipliers
     if (hasStrongPositive && !hasNegation) {
-        positiveScore *= 1.5;
+        positiveScore *= params.strongMultiplier;
     }
     if (hasStrongNegative && !hasNegation) {
-        negativeScore *= 1.5;
+        negativeScore *= params.strongMultiplier;
     }
     
     // Check for emoticons (reduced to most reliable ones)
-    for (const auto& token : tokens) {
-        std::string w = token.c_str();
-        if (w.find(":)") != std::string::npos || w.find(":D") != std::string::npos) {
-            positiveScore += 0.5;
+    for (const TokenType* token = begin; token != end; token++) {
+        if (token->marks & TOKEN_SMILE) {
+            positiveScore += params.emoticonBoost;
         }
-        if (w.find(":(") != std::string::npos) {
-            negativeScore += 0.5;
+        if (token->marks & TOKEN_FROWN) {
+            negativeScore += params.emoticonBoost;
         }
     }
     
     // Final decision with higher confidence threshold
-    const double CONFIDENCE_THRESHOLD = 0.15;  // Increased threshold
     double scoreDiff = positiveScore - negativeScore;
     
-    if (std::abs(scoreDiff) < CONFIDENCE_THRESHOLD) {
+    if (std::abs(scoreDiff) < params.confidence) {  // Increased threshold
         // For borderline cases, rely on strong indicators
         if (hasStrongPositive) return 4;
         if (hasStrongNegative) return 0;
@@ -307,111 +853,563 @@ int SentimentClassifier::predictSentiment(const DSString& text) {
     return (scoreDiff > 0) ? 4 : 0;
 }
 
+// Requires a frozen model (see freeze()); hashed models score through hashedWeights
+int SentimentClassifier::predictSentiment(DSStringView text) const {
+    // One pass over the text; scoring only reads the token records
+    const std::vector<Token>& tokens = threadTokenizer().run(text);
+    const Token* begin = tokens.data();
+    const Token* end = begin + tokens.size();
+    if (features.enabled()) {
+        uint64_t previous = 0;
+        bool hasPrevious = false;
+        return scoreTokens(params, begin, end, [&](const Token& token, WordWeight& weight) {
+            if (token.word.empty()) return FEATURE_NONE;
+            uint64_t hash = Vocabulary::hashWord(token.word);
+            FeatureKind feature = hashedWeights(hasPrevious ? &previous : nullptr, hash, weight);
+            previous = hash;
+            hasPrevious = true;
+            return feature;
+        });
+    }
+    return scoreTokens(params, begin, end, [this](const Token& token, WordWeight& weight) {
+        if (token.word.empty()) return FEATURE_NONE;
+        // Word weights were computed by freeze(); unseen words weigh 0
+        uint32_t id = vocabulary.find(token.word);
+        if (id != Vocabulary::NOT_FOUND) {
+            weight = wordWeights[id];
+        }
+        return FEATURE_WORD;
+    });
+}
+
+namespace {
+    const size_t PREDICT_BATCH_SIZE = 4096;
+    const size_t WRITE_BUFFER_BYTES = 1 << 20;
+
+    // Rows of a test file or corpus on their way through predict's pipeline
+    struct PredictBatch {
+        size_t sequence = 0;   // Position in the input, in batches
+        size_t endOffset = 0;  // Input offset just past the batch's last row (0: keep pages)
+        size_t firstRow = 0;   // Corpus input: tweet index of ids[0]
+        std::vector<CsvField> ids;
+        std::vector<DSStringView> texts;  // CSV input only
+        std::vector<int> results;
+        ScoringMatrix matrix;  // The scorer's workspace
+    };
+
+    // Busy time of the pipeline's reader and writer
+    struct PipelineTimes {
+        uint64_t parseNs = 0;
+        uint64_t writeNs = 0;
+        uint64_t tweets = 0;
+    };
+
+    // Three-stage pipeline: a reader thread fills batches of rows, numScorers
+    // threads score them, and the calling thread writes the results in input
+    // order (so the output does not depend on the thread count) through large
+    // buffered writes. A fixed set of batches circulates through bounded
+    // queues (free -> parsed -> scored -> free), so a stage that falls behind
+    // stalls the others rather than letting memory grow, and input pages are
+    // dropped from the mapping once their rows are written.
+    //
+    // fill(batch) loads up to PREDICT_BATCH_SIZE rows into an empty batch and
+    // returns false once the input is exhausted; score(batch, begin, end)
+    // fills batch.results for rows [begin, end). Without stats a batch is
+    // scored in one call; with stats each row is scored and timed on its own,
+    // so the latency histogram holds true per-tweet times.
+    template <typename Fill, typename Score>
+    void runPredictPipeline(unsigned numScorers, RunStats* stats, const MappedFile& inFile,
+                            std::ofstream& outFile, Fill fill, Score score, PipelineTimes& times) {
+        const size_t numBatches = 2 * numScorers + 2;  // Enough to keep every stage busy
+        std::vector<PredictBatch> batches(numBatches);
+        BoundedQueue<PredictBatch*> freeBatches(numBatches);
+        BoundedQueue<PredictBatch*> parsed(numBatches);
+        BoundedQueue<PredictBatch*> scored(numBatches);
+        for (PredictBatch& batch : batches) {
+            batch.ids.reserve(PREDICT_BATCH_SIZE);
+            batch.results.reserve(PREDICT_BATCH_SIZE);
+            freeBatches.push(&batch);
+        }
+        
+        // The first failure in any stage closes every queue, which stops the others
+        std::mutex failureMutex;
+        std::exception_ptr failure;
+        auto fail = [&](std::exception_ptr error) {
+            {
+                std::lock_guard<std::mutex> lock(failureMutex);
+                if (!failure) failure = error;
+            }
+            freeBatches.close();
+            parsed.close();
+            scored.close();
+        };
+        std::mutex statsMutex;
+        
+        // Stage 1: split the input into batches of rows
+        std::thread reader([&] {
+            try {
+                bool more = true;
+                PredictBatch* batch;
+                for (size_t sequence = 0; more && freeBatches.pop(batch); sequence++) {
+                    uint64_t batchStart = stats ? nowNanos() : 0;
+                    batch->sequence = sequence;
+                    batch->ids.clear();
+                    batch->texts.clear();
+                    more = fill(*batch);
+                    if (stats) times.parseNs += nowNanos() - batchStart;
+                    if (!parsed.push(batch)) return;
+                }
+                parsed.close();
+            }
+            catch (...) {
+                fail(std::current_exception());
+            }
+        });
+        
+        // Stage 2: score batches; the last scorer to finish ends the stream
+        std::atomic<unsigned> activeScorers(numScorers);
+        std::vector<std::thread> scorers;
+        for (unsigned s = 0; s < numScorers; s++) {
+            scorers.emplace_back([&] {
+                try {
+                    LatencyHistogram latency;
+                    PredictBatch* batch;
+                    while (parsed.pop(batch)) {
+                        size_t rows = batch->ids.size();
+                        batch->results.resize(rows);
+                        if (stats) {
+                            for (size_t i = 0; i < rows; i++) {
+                                uint64_t tweetStart = nowNanos();
+                                score(*batch, i, i + 1);
+                                latency.record(nowNanos() - tweetStart);
+                            }
+                        } else {
+                            score(*batch, 0, rows);
+                        }
+                        if (!scored.push(batch)) break;
+                    }
+                    if (stats) {
+                        std::lock_guard<std::mutex> lock(statsMutex);
+                        stats->predictLatency.merge(latency);
+                    }
+                }
+                catch (...) {
+                    fail(std::current_exception());
+                }
+                if (--activeScorers == 0) {
+                    scored.close();
+                }
+            });
+        }
+        
+        // Stage 3 (this thread): put batches back in order and write them out.
+        // At most numBatches batches are in flight, so their sequence numbers
+        // modulo numBatches are distinct and index the reorder slots directly.
+        std::string buffer;
+        try {
+            buffer.reserve(WRITE_BUFFER_BYTES + 64 * PREDICT_BATCH_SIZE);
+            std::vector<PredictBatch*> pending(numBatches, nullptr);
+            size_t nextSequence = 0;
+            size_t dropped = 0;
+            PredictBatch* batch;
+            while (scored.pop(batch)) {
+                pending[batch->sequence % numBatches] = batch;
+                while ((batch = pending[nextSequence % numBatches]) != nullptr) {
+                    uint64_t writeStart = stats ? nowNanos() : 0;
+                    pending[nextSequence % numBatches] = nullptr;
+                    for (size_t i = 0; i < batch->ids.size(); i++) {
+                        char digits[16];
+                        char* digitsEnd = std::to_chars(digits, digits + sizeof(digits), batch->results[i]).ptr;
+                        buffer.append(digits, digitsEnd);
+                        buffer += ',';
+                        buffer.append(batch->ids[i].data, batch->ids[i].length);
+                        buffer += '\n';
+                    }
+                    if (buffer.size() >= WRITE_BUFFER_BYTES) {
+                        outFile.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                        buffer.clear();
+                    }
+                    // The ids were copied into buffer, so the rows' pages can go
+                    if (batch->endOffset > 0) {
+                        dropped = inFile.dropPages(dropped, batch->endOffset);
+                    }
+                    times.tweets += batch->ids.size();
+                    nextSequence++;
+                    if (stats) times.writeNs += nowNanos() - writeStart;
+                    freeBatches.push(batch);
+                }
+            }
+        }
+        catch (...) {
+            fail(std::current_exception());
+        }
+        
+        reader.join();
+        for (std::thread& scorer : scorers) {
+            scorer.join();
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+        
+        uint64_t writeStart = stats ? nowNanos() : 0;
+        outFile.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        outFile.flush();
+        if (!outFile) {
+            throw std::runtime_error("Unable to write predictions file");
+        }
+        if (stats) times.writeNs += nowNanos() - writeStart;
+    }
+}
+
 // Predict sentiments for test data
+// The test file may be a CSV or a test corpus (see Corpus.h); a corpus is
+// scored from its stored tokens, without parsing or tokenizing.
 void SentimentClassifier::predict(const DSString& testFile, const DSString& predictionsFile) {
-    std::ifstream inFile(testFile.c_str());
-    std::ofstream outFile(predictionsFile.c_str());
+    uint64_t start = stats ? nowNanos() : 0;
+    MappedFile inFile;
+    std::optional<Corpus> input = openCorpusOrCsv(testFile.c_str(), inFile);
+    std::ofstream outFile(predictionsFile.c_str(), std::ios::binary);
     
     if (!inFile.is_open() || !outFile.is_open()) {
         throw std::runtime_error("Unable to open test file or predictions file");
     }
     
-    std::string line;
-    // Skip header
-    std::getline(inFile, line);
+    if (!frozen) {
+        freeze();
+    }
     
-    while (std::getline(inFile, line)) {
-        std::stringstream ss(line);
-        std::string id, date, query, user, text;
-        
-        // Parse CSV line (note: id is first in test data)
-        std::getline(ss, id, ',');
-        std::getline(ss, date, ',');
-        std::getline(ss, query, ',');
-        std::getline(ss, user, ',');
-        std::getline(ss, text);
-        
-        // Remove quotes if present
-        if (text.front() == '"') text = text.substr(1);
-        if (text.back() == '"') text = text.substr(0, text.length() - 1);
-        
-        int sentiment = predictSentiment(DSString(text.c_str()));
-        outFile << sentiment << "," << id << std::endl;
+    uint64_t scoreNsBefore = stats ? stats->predictLatency.totalNanos() : 0;
+    PipelineTimes times;
+    if (input) {
+        const Corpus& corpus = *input;
+        if (corpus.kind() != CorpusKind::Test) {
+            throw std::runtime_error("Predictions need a test corpus");
+        }
+        // Look every dictionary word up (or hash it) once; tokens then index these tables
+        bool hashed = features.enabled();
+        std::vector<uint32_t> modelIds(hashed ? 0 : corpus.numWords());
+        for (uint32_t word = 0; word < modelIds.size(); word++) {
+            modelIds[word] = vocabulary.find(corpus.word(word));
+        }
+        std::vector<uint64_t> wordHashes(hashed ? corpus.numWords() : 0);
+        for (uint32_t word = 0; word < wordHashes.size(); word++) {
+            wordHashes[word] = Vocabulary::hashWord(corpus.word(word));
+        }
+        size_t nextTweet = 0;
+        auto fill = [&](PredictBatch& batch) {
+            batch.firstRow = nextTweet;
+            size_t end = std::min(corpus.size(), nextTweet + PREDICT_BATCH_SIZE);
+            for (; nextTweet < end; nextTweet++) {
+                DSStringView id = corpus.id(nextTweet);
+                batch.ids.push_back(CsvField{id.data(), id.getLength()});
+            }
+            return nextTweet < corpus.size();
+        };
+        const uint32_t unseen = static_cast<uint32_t>(vocabulary.size());
+        auto score = [&](PredictBatch& batch, size_t begin, size_t end) {
+            if (hashed) {
+                for (size_t i = begin; i < end; i++) {
+                    size_t tweet = batch.firstRow + i;
+                    uint64_t previous = 0;
+                    bool hasPrevious = false;
+                    batch.results[i] = scoreTokens(params, corpus.tokensBegin(tweet), corpus.tokensEnd(tweet),
+                                                   [&](const CorpusToken& token, WordWeight& weight) {
+                        if (token.word == CORPUS_NO_WORD) return FEATURE_NONE;
+                        uint64_t hash = wordHashes[token.word];
+                        FeatureKind feature = hashedWeights(hasPrevious ? &previous : nullptr, hash, weight);
+                        previous = hash;
+                        hasPrevious = true;
+                        return feature;
+                    });
+                }
+                return;
+            }
+            // The stored tokens become matrix rows without tokenizing or hashing
+            batch.matrix.clear();
+            for (size_t tweet = batch.firstRow + begin; tweet < batch.firstRow + end; tweet++) {
+                batch.matrix.addRow(corpus.tokensBegin(tweet), corpus.tokensEnd(tweet),
+                                    [&](const CorpusToken& token) {
+                    if (token.word == CORPUS_NO_WORD) return ScoringMatrix::NO_COLUMN;
+                    uint32_t id = modelIds[token.word];
+                    return id != Vocabulary::NOT_FOUND ? id : unseen;
+                });
+            }
+            batch.matrix.score(wordWeights.data(), params, batch.results.data() + begin);
+        };
+        runPredictPipeline(numThreads, stats, inFile, outFile, fill, score, times);
+    } else {
+        CsvReader reader(inFile);
+        CsvField line;
+        // Skip header
+        reader.nextLine(line);
+        auto fill = [&](PredictBatch& batch) {
+            bool more = true;
+            while (batch.ids.size() < PREDICT_BATCH_SIZE && (more = reader.nextLine(line))) {
+                // id, date, query, user, text (note: id is first in test data)
+                CsvField fields[5];
+                CsvReader::splitFields(line, fields, 5);
+                
+                // Remove quotes if present
+                batch.ids.push_back(fields[0]);
+                CsvField text = fields[4].unquoted();
+                batch.texts.push_back(DSStringView(text.data, text.length));
+            }
+            batch.endOffset = reader.position(inFile.data());
+            return more;
+        };
+        auto score = [this](PredictBatch& batch, size_t begin, size_t end) {
+            classifyBatch(batch.texts.data() + begin, end - begin, batch.results.data() + begin, batch.matrix);
+        };
+        runPredictPipeline(numThreads, stats, inFile, outFile, fill, score, times);
+    }
+    
+    if (stats) {
+        stats->addPhase("predict", start, nowNanos(), times.tweets, inFile.size());
+        stats->addPhase("predict.parse", 0, times.parseNs);
+        stats->addThreadPhase("predict.score", stats->predictLatency.totalNanos() - scoreNsBefore);
+        stats->addPhase("predict.write", 0, times.writeNs);
     }
 }
 
 // Evaluate predictions against ground truth
+// Rows are joined by tweet id (see Evaluation.h), so the predictions may be in
+// any order; nothing is printed per row.
 void SentimentClassifier::evaluatePredictions(const DSString& groundTruthFile,
                                             const DSString& predictionsFile,
                                             const DSString& accuracyFile) {
-    std::ifstream truthFile(groundTruthFile.c_str());
-    std::ifstream predFile(predictionsFile.c_str());
+    uint64_t start = stats ? nowNanos() : 0;
+    MappedFile truthFile(groundTruthFile.c_str());
+    MappedFile predFile(predictionsFile.c_str());
     std::ofstream accFile(accuracyFile.c_str());
     
     if (!truthFile.is_open() || !predFile.is_open() || !accFile.is_open()) {
         throw std::runtime_error("Unable to open files for evaluation");
     }
     
-    // Skip header in truth file
-    std::string header;
-    std::getline(truthFile, header);
+    ThreadPool pool(numThreads);
+    EvaluationResult result = evaluate(truthFile, predFile, pool);
     
-    int correct = 0;
-    int total = 0;
-    std::vector<std::pair<DSString, std::pair<int, int>>> errors; // id, (predicted, actual)
+    if (result.total == 0) {
+        throw std::runtime_error("No valid predictions processed");
+    }
+    if (result.missing > 0) {
+        std::cerr << "Warning: " << result.missing << " tweets have no prediction" << std::endl;
+    }
     
-    std::string truthLine, predLine;
-    while (std::getline(truthFile, truthLine) && std::getline(predFile, predLine)) {
+    // Accuracy, errors and metrics
+    writeAccuracyReport(result, accFile);
+    accFile.flush();
+    
+    if (stats) {
+        stats->addPhase("evaluate", start, nowNanos(), result.total,
+                        truthFile.size() + predFile.size());
+    }
+}
+
+namespace {
+    // Labelled test tweets per sweep scoring matrix
+    const size_t SWEEP_MATRIX_ROWS = 1 << 16;
+
+    // Occurrences of one training word, by label ([0] negative, [1] positive)
+    // and by whether the token was emphatic
+    struct WordOccurrences {
+        uint32_t plain[2] = {0, 0};
+        uint32_t emphatic[2] = {0, 0};
+    };
+
+    // Maps path as a corpus; a CSV is compiled to a temporary corpus first, a
+    // fresh file under $TMPDIR (or /tmp) that is unlinked as soon as it is mapped
+    Corpus mapCorpus(const DSString& path, MappedFile& file) {
+        if (std::optional<Corpus> corpus = openCorpusOrCsv(path.c_str(), file)) {
+            return *corpus;
+        }
+        if (!file.is_open()) {
+            throw std::runtime_error("Unable to open " + std::string(path.c_str()));
+        }
+        file.close();
+        const char* directory = std::getenv("TMPDIR");
+        std::string scratch = std::string(directory && *directory ? directory : "/tmp") + "/sentiment-sweep-XXXXXX";
+        int fd = mkstemp(&scratch[0]);
+        if (fd < 0) {
+            throw std::runtime_error("Unable to create a temporary corpus in " + scratch.substr(0, scratch.rfind('/')));
+        }
+        close(fd);
         try {
-            std::stringstream truthSS(truthLine);
-            std::stringstream predSS(predLine);
-            
-            std::string truthSentiment, truthId, predSentiment, predId;
-            
-            std::getline(truthSS, truthSentiment, ',');
-            std::getline(truthSS, truthId);
-            std::getline(predSS, predSentiment, ',');
-            std::getline(predSS, predId);
-            
-            // Debug output
-            std::cout << "Processing:" << std::endl;
-            std::cout << "Truth line: " << truthLine << std::endl;
-            std::cout << "Pred line: " << predLine << std::endl;
-            
-            // Trim whitespace
-            truthSentiment.erase(0, truthSentiment.find_first_not_of(" \t\r\n"));
-            truthSentiment.erase(truthSentiment.find_last_not_of(" \t\r\n") + 1);
-            predSentiment.erase(0, predSentiment.find_first_not_of(" \t\r\n"));
-            predSentiment.erase(predSentiment.find_last_not_of(" \t\r\n") + 1);
-            
-            if (truthSentiment == predSentiment) {
-                correct++;
-            } else {
-                errors.push_back({DSString(truthId.c_str()),
-                                {std::stoi(predSentiment),
-                                 std::stoi(truthSentiment)}});
+            compileCorpus(path.c_str(), scratch.c_str());
+        } catch (...) {
+            std::remove(scratch.c_str());
+            throw;
+        }
+        bool opened = file.open(scratch.c_str(), false);
+        std::remove(scratch.c_str());
+        if (!opened) {
+            throw std::runtime_error("Unable to map compiled corpus");
+        }
+        return Corpus(file);
+    }
+}
+
+// Evaluate a grid of parameter settings on shared pre-tokenized data
+// Training counts depend on the parameters only through each occurrence's
+// weight, so one pass records every word's occurrences by label and
+// emphasis; a setting's counts are then weight * occurrences per word, the
+// same sums train() would make. Truth rows pair with test tweets by id like
+// evaluate(): the k-th truth row of an id with the k-th tweet of that id.
+std::vector<SweepResult> SentimentClassifier::sweep(const DSString& trainingFile, const DSString& testFile,
+                                                    const DSString& groundTruthFile,
+                                                    const std::vector<ClassifierParams>& grid) {
+    uint64_t start = stats ? nowNanos() : 0;
+    MappedFile trainFile;
+    MappedFile testMapping;
+    Corpus train = mapCorpus(trainingFile, trainFile);
+    Corpus test = mapCorpus(testFile, testMapping);
+    if (train.kind() != CorpusKind::Training || test.kind() != CorpusKind::Test) {
+        throw std::runtime_error("Sweep needs a training file and a test file");
+    }
+    ThreadPool pool(numThreads);
+    
+    // Occurrences per training word, counted in shards of tweets
+    size_t numShards = std::max<size_t>(1, std::min<size_t>(numThreads, train.size()));
+    std::vector<std::vector<WordOccurrences>> shards(numShards, std::vector<WordOccurrences>(train.numWords()));
+    pool.parallelFor(numShards, [&](size_t begin, size_t end) {
+        for (size_t shard = begin; shard < end; shard++) {
+            std::vector<WordOccurrences>& occurrences = shards[shard];
+            size_t last = train.size() * (shard + 1) / numShards;
+            for (size_t tweet = train.size() * shard / numShards; tweet < last; tweet++) {
+                int label = train.label(tweet) == 4 ? 1 : 0;
+                for (const CorpusToken* token = train.tokensBegin(tweet); token != train.tokensEnd(tweet); token++) {
+                    if (token->word == CORPUS_NO_WORD) continue;
+                    WordOccurrences& word = occurrences[token->word];
+                    (token->marks & TOKEN_EMPHATIC ? word.emphatic : word.plain)[label]++;
+                }
             }
-            total++;
         }
-        catch (const std::exception& e) {
-            std::cerr << "Error processing line: " << e.what() << std::endl;
-            std::cerr << "Truth line: " << truthLine << std::endl;
-            std::cerr << "Pred line: " << predLine << std::endl;
-            throw;
+    });
+    std::vector<WordOccurrences>& occurrences = shards[0];
+    for (size_t shard = 1; shard < numShards; shard++) {
+        for (size_t word = 0; word < occurrences.size(); word++) {
+            for (int label = 0; label < 2; label++) {
+                occurrences[word].plain[label] += shards[shard][word].plain[label];
+                occurrences[word].emphatic[label] += shards[shard][word].emphatic[label];
+            }
         }
     }
     
-    if (total == 0) {
-        throw std::runtime_error("No valid predictions processed");
+    // Test dictionary words resolved to training words once
+    Vocabulary trainWords;
+    for (uint32_t word = 0; word < train.numWords(); word++) {
+        trainWords.intern(train.word(word));  // Dictionary words are distinct, so ids match
+    }
+    std::vector<uint32_t> trainIds(test.numWords());
+    for (uint32_t word = 0; word < trainIds.size(); word++) {
+        trainIds[word] = trainWords.find(test.word(word));
+    }
+    
+    // Truth label of each test tweet (-1: none)
+    MappedFile truthFile(groundTruthFile.c_str());
+    if (!truthFile.is_open()) {
+        throw std::runtime_error("Unable to open ground truth file");
+    }
+    Vocabulary testIds;
+    std::vector<uint32_t> tweetIds(test.size());
+    for (size_t tweet = 0; tweet < test.size(); tweet++) {
+        tweetIds[tweet] = testIds.intern(test.id(tweet));
+    }
+    std::vector<std::pair<uint32_t, int8_t>> truthRows;
+    CsvReader reader(truthFile);
+    CsvField line;
+    reader.nextLine(line);  // Header
+    while (reader.nextLine(line)) {
+        if (line.trimmed().empty()) continue;
+        CsvField fields[2];
+        CsvReader::splitFields(line, fields, 2);
+        CsvField label = fields[0].trimmed();
+        CsvField tweetId = fields[1].trimmed();
+        if (label.length != 1 || label.front() < '0' || label.front() > '4') {
+            throw std::runtime_error("Invalid sentiment in line: " + line.str());
+        }
+        uint32_t id = testIds.find(DSStringView(tweetId.data, tweetId.length));
+        if (id != Vocabulary::NOT_FOUND) {
+            truthRows.emplace_back(id, static_cast<int8_t>(label.front() - '0'));
+        }
+    }
+    // Counting sort by id keeps each id's rows in file order
+    std::vector<uint32_t> firstRow(testIds.size() + 1, 0);
+    for (const auto& row : truthRows) firstRow[row.first + 1]++;
+    for (size_t id = 0; id < testIds.size(); id++) firstRow[id + 1] += firstRow[id];
+    std::vector<int8_t> labelsById(truthRows.size());
+    std::vector<uint32_t> filled(firstRow.begin(), firstRow.end() - 1);
+    for (const auto& row : truthRows) labelsById[filled[row.first]++] = row.second;
+    std::vector<int8_t> labels(test.size(), -1);
+    std::vector<uint32_t> seen(firstRow.begin(), firstRow.end() - 1);
+    for (size_t tweet = 0; tweet < test.size(); tweet++) {
+        uint32_t id = tweetIds[tweet];
+        if (seen[id] < firstRow[id + 1]) labels[tweet] = labelsById[seen[id]++];
     }
     
-    // Write accuracy
-    double accuracy = static_cast<double>(correct) / total;
-    accFile << std::fixed << std::setprecision(3) << accuracy << std::endl;
+    // The labelled test tweets as scoring matrices over training word ids,
+    // which every setting scores with its own weights; column numWords() is
+    // the zero weight of words the training data lacks
+    std::vector<size_t> labelled;
+    for (size_t tweet = 0; tweet < test.size(); tweet++) {
+        if (labels[tweet] >= 0) labelled.push_back(tweet);
+    }
+    const uint32_t unseen = static_cast<uint32_t>(train.numWords());
+    std::vector<ScoringMatrix> matrices((labelled.size() + SWEEP_MATRIX_ROWS - 1) / SWEEP_MATRIX_ROWS);
+    pool.parallelFor(matrices.size(), [&](size_t begin, size_t end) {
+        for (size_t m = begin; m < end; m++) {
+            size_t last = std::min(labelled.size(), (m + 1) * SWEEP_MATRIX_ROWS);
+            for (size_t i = m * SWEEP_MATRIX_ROWS; i < last; i++) {
+                size_t tweet = labelled[i];
+                matrices[m].addRow(test.tokensBegin(tweet), test.tokensEnd(tweet), [&](const CorpusToken& token) {
+                    if (token.word == CORPUS_NO_WORD) return ScoringMatrix::NO_COLUMN;
+                    uint32_t id = trainIds[token.word];
+                    return id != Vocabulary::NOT_FOUND ? id : unseen;
+                });
+            }
+        }
+    });
+    uint64_t prepared = stats ? nowNanos() : 0;
     
-    // Write errors
-    for (const auto& error : errors) {
-        accFile << error.second.first << "," << error.second.second << "," 
-                << error.first << std::endl;
+    // Settings in parallel; each builds its own weight table
+    std::vector<SweepResult> results(grid.size());
+    pool.parallelFor(grid.size(), [&](size_t begin, size_t end) {
+        std::vector<WordWeight> weights(train.numWords() + 1, WordWeight{0, 0});
+        std::vector<int> predicted(SWEEP_MATRIX_ROWS);
+        for (size_t setting = begin; setting < end; setting++) {
+            const ClassifierParams& settingParams = grid[setting];
+            for (uint32_t word = 0; word < unseen; word++) {
+                const CorpusWord& info = train.wordInfo(word);
+                WordCount count;
+                for (int label = 0; label < 2; label++) {
+                    for (int emphatic = 0; emphatic < 2; emphatic++) {
+                        uint32_t n = emphatic ? occurrences[word].emphatic[label] : occurrences[word].plain[label];
+                        if (n == 0) continue;
+                        bool isPositive = label == 1;
+                        int weight = wordWeight(settingParams, info.trainWeight, info.flags, emphatic != 0, isPositive);
+                        (isPositive ? count.pos : count.neg) += static_cast<int32_t>(n) * weight;
+                    }
+                }
+                weights[word] = weightOf(count, 1.0);
+            }
+            
+            SweepResult& result = results[setting];
+            result.params = settingParams;
+            for (size_t m = 0; m < matrices.size(); m++) {
+                matrices[m].score(weights.data(), settingParams, predicted.data());
+                for (size_t row = 0; row < matrices[m].numRows(); row++) {
+                    result.correct += predicted[row] == labels[labelled[m * SWEEP_MATRIX_ROWS + row]];
+                }
+            }
+            result.total = labelled.size();
+        }
+    });
+    
+    if (stats) {
+        stats->addPhase("sweep.prepare", start, prepared, train.size() + test.size(),
+                        trainFile.size() + testMapping.size());
+        stats->addPhase("sweep.score", prepared, nowNanos(), grid.size() * test.size());
     }
-} 
\ No newline at end of file
+    return results;
+}
@@ -0,0 +1,99 @@
+#include "Sweep.h"
+#include <cmath>
+#include <iomanip>
+#include <stdexcept>
+
+namespace {
+    // Column order of the results file
+    const char* const PARAM_NAMES[] = {
+        "emoticon_weight", "strong_weight", "emphatic_weight",
+        "clarity", "strong_boost", "strong_multiplier", "emoticon_boost", "confidence"
+    };
+
+    double parseNumber(const std::string& text, const std::string& spec) {
+        try {
+            size_t used = 0;
+            double value = std::stod(text, &used);
+            if (used == text.size()) {
+                return value;
+            }
+        } catch (const std::exception&) {
+        }
+        throw std::runtime_error("Invalid value in " + spec);
+    }
+
+    int weightValue(const std::string& name, double value) {
+        if (!(value >= 1 && value <= 1000) || value != std::floor(value)) {
+            throw std::runtime_error(name + " must be a positive integer");
+        }
+        return static_cast<int>(value);
+    }
+}
+
+void setClassifierParam(ClassifierParams& params, const std::string& name, double value) {
+    if (name == "emoticon_weight") params.emoticonWeight = weightValue(name, value);
+    else if (name == "strong_weight") params.strongWordWeight = weightValue(name, value);
+    else if (name == "emphatic_weight") params.emphaticWeight = weightValue(name, value);
+    else if (name == "clarity") params.clarity = value;
+    else if (name == "strong_boost") params.strongBoost = value;
+    else if (name == "strong_multiplier") params.strongMultiplier = value;
+    else if (name == "emoticon_boost") params.emoticonBoost = value;
+    else if (name == "confidence") params.confidence = value;
+    else throw std::runtime_error("Unknown parameter " + name);
+}
+
+void parseClassifierParam(ClassifierParams& params, const std::string& spec) {
+    size_t equals = spec.find('=');
+    if (equals == std::string::npos) {
+        throw std::runtime_error("Expected name=value, got " + spec);
+    }
+    setClassifierParam(params, spec.substr(0, equals), parseNumber(spec.substr(equals + 1), spec));
+}
+
+SweepAxis parseSweepAxis(const std::string& spec) {
+    size_t equals = spec.find('=');
+    if (equals == std::string::npos || equals == 0) {
+        throw std::runtime_error("Expected name=v1,v2,..., got " + spec);
+    }
+    SweepAxis axis;
+    axis.name = spec.substr(0, equals);
+    size_t start = equals + 1;
+    while (true) {
+        size_t comma = spec.find(',', start);
+        axis.values.push_back(parseNumber(spec.substr(start, comma - start), spec));
+        if (comma == std::string::npos) break;
+        start = comma + 1;
+    }
+    return axis;
+}
+
+std::vector<ClassifierParams> expandGrid(const ClassifierParams& base, const std::vector<SweepAxis>& axes) {
+    std::vector<ClassifierParams> grid(1, base);
+    for (const SweepAxis& axis : axes) {
+        std::vector<ClassifierParams> expanded;
+        expanded.reserve(grid.size() * axis.values.size());
+        for (const ClassifierParams& params : grid) {
+            for (double value : axis.values) {
+                expanded.push_back(params);
+                setClassifierParam(expanded.back(), axis.name, value);
+            }
+        }
+        grid.swap(expanded);
+    }
+    return grid;
+}
+
+void writeSweepResults(const std::vector<SweepResult>& results, std::ostream& out) {
+    for (const char* name : PARAM_NAMES) {
+        out << name << ',';
+    }
+    out << "accuracy,correct,total\n";
+    for (const SweepResult& result : results) {
+        const ClassifierParams& params = result.params;
+        out << params.emoticonWeight << ',' << params.strongWordWeight << ',' << params.emphaticWeight << ','
+            << params.clarity << ',' << params.strongBoost << ',' << params.strongMultiplier << ','
+            << params.emoticonBoost << ',' << params.confidence << ','
+            << std::fixed << std::setprecision(4) << result.accuracy() << std::defaultfloat << ','
+            << result.correct << ',' << result.total << '\n';
+    }
+}
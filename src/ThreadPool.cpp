@@ -0,0 +1,90 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned threads) {
+    for (unsigned i = 1; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+// Claims chunks of the current job until none are left
+void ThreadPool::runChunks() {
+    std::unique_lock<std::mutex> lock(mutex);
+    activeRunners++;
+    while (nextChunk < numChunks) {
+        size_t chunk = nextChunk++;
+        const RangeFn* body = job;
+        size_t begin = chunk * chunkSize;
+        size_t end = begin + chunkSize < jobCount ? begin + chunkSize : jobCount;
+        lock.unlock();
+        try {
+            (*body)(begin, end);
+        } catch (...) {
+            lock.lock();
+            if (!failure) failure = std::current_exception();
+            nextChunk = numChunks;  // Abandon the remaining chunks
+            continue;
+        }
+        lock.lock();
+    }
+    if (--activeRunners == 0) {
+        done.notify_all();
+    }
+}
+
+void ThreadPool::workerLoop() {
+    unsigned long seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&]() { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+        }
+        runChunks();
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, const RangeFn& body) {
+    if (count == 0) return;
+    if (workers.empty()) {
+        body(0, count);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // A few chunks per thread keeps the load balanced on uneven rows
+        size_t targetChunks = static_cast<size_t>(size()) * 4;
+        job = &body;
+        jobCount = count;
+        chunkSize = (count + targetChunks - 1) / targetChunks;
+        numChunks = (count + chunkSize - 1) / chunkSize;
+        nextChunk = 0;
+        failure = nullptr;
+        generation++;
+    }
+    wake.notify_all();
+
+    runChunks();
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&]() { return activeRunners == 0 && nextChunk >= numChunks; });
+        job = nullptr;
+        error = failure;
+        failure = nullptr;
+    }
+    if (error) std::rethrow_exception(error);
+}
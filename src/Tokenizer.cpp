@@ -0,0 +1,316 @@
+#include "Tokenizer.h"
+#include "Lexicon.h"
+#include <array>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define TOKENIZER_X86 1
+#endif
+
+namespace {
+    // Character classes driving the tokenizer
+    enum CharClass : uint8_t {
+        CH_DELIM     = 1 << 0,  // ' ' ',' '\t' '\n' end a word
+        CH_PUNCT     = 1 << 1,  // '!' '?' '.' form punctuation runs
+        CH_EMO_LEAD  = 1 << 2,  // ':' '=' ';' may start an emoticon
+        CH_EMO_TAIL  = 1 << 3,  // ')' '(' 'D' 'P' complete an emoticon
+        CH_ALPHA     = 1 << 4,  // Kept by preprocessWord (isalpha, "C" locale)
+        CH_KEEP_RAW  = 1 << 5,  // ':' '=' '!' keep tokens of <= 3 chars verbatim
+        CH_COLON     = 1 << 6,  // ':' may form a smile/frown
+        CH_SPECIAL   = CH_DELIM | CH_PUNCT | CH_EMO_LEAD  // Ends a plain run
+    };
+
+    struct CharTables {
+        std::array<uint8_t, 256> classes{};
+        std::array<char, 256> lower{};
+    };
+
+    constexpr CharTables buildTables() {
+        CharTables tables;
+        for (int c = 0; c < 256; c++) {
+            uint8_t cls = 0;
+            char ch = static_cast<char>(c);
+            if (ch == ' ' || ch == ',' || ch == '\t' || ch == '\n') cls |= CH_DELIM;
+            if (ch == '!' || ch == '?' || ch == '.') cls |= CH_PUNCT;
+            if (ch == ':' || ch == '=' || ch == ';') cls |= CH_EMO_LEAD;
+            if (ch == ')' || ch == '(' || ch == 'D' || ch == 'P') cls |= CH_EMO_TAIL;
+            bool upper = c >= 'A' && c <= 'Z';
+            if (upper || (c >= 'a' && c <= 'z')) cls |= CH_ALPHA;
+            if (ch == ':' || ch == '=' || ch == '!') cls |= CH_KEEP_RAW;
+            if (ch == ':') cls |= CH_COLON;
+            tables.classes[c] = cls;
+            tables.lower[c] = static_cast<char>(upper ? c - 'A' + 'a' : c);
+        }
+        return tables;
+    }
+
+    constexpr CharTables TABLES = buildTables();
+
+    inline uint8_t classOf(char c) {
+        return TABLES.classes[static_cast<uint8_t>(c)];
+    }
+
+    // Portable kernel, also used for the tail of the vector kernels
+    size_t plainRunScalar(const char* src, size_t n, char* word, size_t& wordLength,
+                          char* lowered, size_t& length) {
+        size_t i = 0;
+        for (; i < n; i++) {
+            uint8_t cls = classOf(src[i]);
+            if (cls & CH_SPECIAL) break;
+            char low = TABLES.lower[static_cast<uint8_t>(src[i])];
+            if (length < Tokenizer::MAX_LEXICON_LENGTH) lowered[length] = low;
+            if (cls & CH_ALPHA) word[wordLength++] = low;
+            length++;
+        }
+        return i;
+    }
+
+#ifdef TOKENIZER_X86
+    // Appends the letters selected by alphaMask from a lowercased block
+    inline void appendLetters(const char* block, unsigned alphaMask, size_t take,
+                              char* word, size_t& wordLength) {
+        if (alphaMask == (take == 32 ? 0xFFFFFFFFu : (1u << take) - 1)) {
+            // Whole prefix is letters; the caller already stored the block
+            wordLength += take;
+            return;
+        }
+        while (alphaMask) {
+            word[wordLength++] = block[__builtin_ctz(alphaMask)];
+            alphaMask &= alphaMask - 1;
+        }
+    }
+
+    size_t plainRunSse2(const char* src, size_t n, char* word, size_t& wordLength,
+                        char* lowered, size_t& length) {
+        const __m128i bias = _mm_set1_epi8(static_cast<char>(0x80));
+        const __m128i upperA = _mm_set1_epi8('A');
+        const __m128i lowerA = _mm_set1_epi8('a');
+        const __m128i span = _mm_set1_epi8(static_cast<char>(26 ^ 0x80));
+        const __m128i caseBit = _mm_set1_epi8(0x20);
+        size_t i = 0;
+        while (i + 16 <= n) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+            __m128i special = _mm_or_si128(
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))),
+                             _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\t')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\n')))),
+                _mm_or_si128(
+                    _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('!')), _mm_cmpeq_epi8(v, _mm_set1_epi8('?'))),
+                                 _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('.')), _mm_cmpeq_epi8(v, _mm_set1_epi8(':')))),
+                    _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('=')), _mm_cmpeq_epi8(v, _mm_set1_epi8(';')))));
+            unsigned specialMask = static_cast<unsigned>(_mm_movemask_epi8(special));
+
+            // Unsigned range checks via the sign-flip trick: (c - 'A') < 26
+            __m128i isUpper = _mm_cmplt_epi8(_mm_xor_si128(_mm_sub_epi8(v, upperA), bias), span);
+            __m128i isLower = _mm_cmplt_epi8(_mm_xor_si128(_mm_sub_epi8(v, lowerA), bias), span);
+            __m128i low = _mm_or_si128(v, _mm_and_si128(isUpper, caseBit));
+            unsigned alphaMask = static_cast<unsigned>(_mm_movemask_epi8(_mm_or_si128(isUpper, isLower)));
+
+            size_t take = specialMask ? static_cast<size_t>(__builtin_ctz(specialMask)) : 16;
+            alphaMask &= (1u << take) - 1;
+            if (length < Tokenizer::MAX_LEXICON_LENGTH) {
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(lowered + length), low);
+            }
+            alignas(16) char block[16];
+            _mm_store_si128(reinterpret_cast<__m128i*>(block), low);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(word + wordLength), low);
+            appendLetters(block, alphaMask, take, word, wordLength);
+            length += take;
+            i += take;
+            if (take < 16) return i;
+        }
+        return i + plainRunScalar(src + i, n - i, word, wordLength, lowered, length);
+    }
+
+    __attribute__((target("avx2")))
+    size_t plainRunAvx2(const char* src, size_t n, char* word, size_t& wordLength,
+                        char* lowered, size_t& length) {
+        const __m256i bias = _mm256_set1_epi8(static_cast<char>(0x80));
+        const __m256i upperA = _mm256_set1_epi8('A');
+        const __m256i lowerA = _mm256_set1_epi8('a');
+        const __m256i span = _mm256_set1_epi8(static_cast<char>(26 ^ 0x80));
+        const __m256i caseBit = _mm256_set1_epi8(0x20);
+        size_t i = 0;
+        while (i + 32 <= n) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+            __m256i special = _mm256_or_si256(
+                _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(','))),
+                                _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\t')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\n')))),
+                _mm256_or_si256(
+                    _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('!')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('?'))),
+                                    _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('.')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(':')))),
+                    _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('=')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8(';')))));
+            unsigned specialMask = static_cast<unsigned>(_mm256_movemask_epi8(special));
+
+            // Unsigned range checks via the sign-flip trick: (c - 'A') < 26
+            __m256i isUpper = _mm256_cmpgt_epi8(span, _mm256_xor_si256(_mm256_sub_epi8(v, upperA), bias));
+            __m256i isLower = _mm256_cmpgt_epi8(span, _mm256_xor_si256(_mm256_sub_epi8(v, lowerA), bias));
+            __m256i low = _mm256_or_si256(v, _mm256_and_si256(isUpper, caseBit));
+            unsigned alphaMask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_or_si256(isUpper, isLower)));
+
+            size_t take = specialMask ? static_cast<size_t>(__builtin_ctz(specialMask)) : 32;
+            if (take < 32) alphaMask &= (1u << take) - 1;
+            if (length < Tokenizer::MAX_LEXICON_LENGTH) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(lowered + length), low);
+            }
+            alignas(32) char block[32];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(block), low);
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(word + wordLength), low);
+            appendLetters(block, alphaMask, take, word, wordLength);
+            length += take;
+            i += take;
+            if (take < 32) return i;
+        }
+        return i + plainRunSse2(src + i, n - i, word, wordLength, lowered, length);
+    }
+#endif
+}
+
+Tokenizer::Tokenizer(Isa isa) : isa(isSupported(isa) ? isa : Isa::Scalar) {
+    switch (this->isa) {
+#ifdef TOKENIZER_X86
+        case Isa::AVX2: plainRun = plainRunAvx2; break;
+        case Isa::SSE2: plainRun = plainRunSse2; break;
+#endif
+        default: plainRun = plainRunScalar; break;
+    }
+}
+
+Tokenizer::Isa Tokenizer::detectIsa() {
+    if (isSupported(Isa::AVX2)) return Isa::AVX2;
+    if (isSupported(Isa::SSE2)) return Isa::SSE2;
+    return Isa::Scalar;
+}
+
+bool Tokenizer::isSupported(Isa isa) {
+    switch (isa) {
+#ifdef TOKENIZER_X86
+        case Isa::AVX2: return __builtin_cpu_supports("avx2");
+        case Isa::SSE2: return true;  // Part of the x86-64 baseline
+#endif
+        case Isa::Scalar: return true;
+        default: return false;
+    }
+}
+
+const char* Tokenizer::isaName(Isa isa) {
+    switch (isa) {
+        case Isa::AVX2: return "avx2";
+        case Isa::SSE2: return "sse2";
+        default: return "scalar";
+    }
+}
+
+static_assert(lexicon::maxLength() <= Tokenizer::MAX_LEXICON_LENGTH,
+              "Lowercase buffer too short for the lexicon");
+
+inline void Tokenizer::pushByte(char c, uint8_t cls) {
+    char low = TABLES.lower[static_cast<uint8_t>(c)];
+    if (currentLength < MAX_LEXICON_LENGTH) lowered[currentLength] = low;
+    if (cls & CH_ALPHA) words[wordsUsed + currentWordLength++] = low;
+    currentClasses |= cls;
+    currentLength++;
+}
+
+void Tokenizer::discardToken() {
+    currentLength = 0;
+    currentWordLength = 0;
+    currentClasses = 0;
+}
+
+void Tokenizer::finishToken(const char* begin, size_t length) {
+    const char* word = words.data() + wordsUsed;
+
+    Token token;
+    token.raw = DSStringView(begin, length);
+    token.rawFlags = length <= MAX_LEXICON_LENGTH ? lexiconFlags(DSStringView(lowered, length)) : 0;
+    token.wordFlags = 0;
+    token.trainWeight = 1;
+    token.marks = 0;
+
+    bool verbatim = length <= 3 && (currentClasses & CH_KEEP_RAW);
+    if (verbatim) {
+        // Emoticons and short punctuation runs are kept as written
+        token.word = token.raw;
+        if (token.word.contains("!!!") || token.word.contains("???")) token.marks |= TOKEN_EMPHATIC;
+    } else {
+        token.word = DSStringView(word, currentWordLength);
+    }
+
+    if (!token.word.empty()) {
+        const LexiconEntry* entry = lookupLexicon(token.word);
+        if (entry != nullptr && (entry->flags & LEX_STOP_WORD) && !verbatim) {
+            token.word = DSStringView();  // Stop words are dropped
+        } else if (entry != nullptr) {
+            token.wordFlags = entry->flags;
+            token.trainWeight = entry->trainWeight;
+        }
+    }
+    if (!verbatim) {
+        wordsUsed += token.word.getLength();
+    }
+
+    if (currentClasses & CH_COLON) {
+        if (token.raw.contains(":)") || token.raw.contains(":D")) token.marks |= TOKEN_SMILE;
+        if (token.raw.contains(":(")) token.marks |= TOKEN_FROWN;
+    }
+    tokens.push_back(token);
+    discardToken();
+}
+
+const std::vector<Token>& Tokenizer::run(DSStringView text) {
+    tokens.clear();
+    // Normalized words are never longer than the text, so views stay valid
+    if (words.size() < text.getLength() + BLOCK_SLACK) words.resize(text.getLength() + BLOCK_SLACK);
+    wordsUsed = 0;
+    discardToken();
+
+    const char* str = text.data();
+    size_t length = text.getLength();
+    size_t start = 0;  // First character of the word being collected
+
+    for (size_t i = 0; i < length; i++) {
+        char c = str[i];
+        uint8_t cls = classOf(c);
+
+        // Emoticons: lead followed by tail
+        if ((cls & CH_EMO_LEAD) && i + 1 < length && (classOf(str[i + 1]) & CH_EMO_TAIL)) {
+            if (i > start) finishToken(str + start, i - start);
+            pushByte(c, cls);
+            pushByte(str[i + 1], classOf(str[i + 1]));
+            finishToken(str + i, 2);
+            i++;
+            start = i + 1;
+            continue;
+        }
+
+        // Runs of '!', '?' and '.'; only runs longer than one are tokens
+        if (cls & CH_PUNCT) {
+            if (i > start) finishToken(str + start, i - start);
+            size_t end = i;
+            while (end < length && (classOf(str[end]) & CH_PUNCT)) {
+                pushByte(str[end], classOf(str[end]));
+                end++;
+            }
+            if (end - i > 1) finishToken(str + i, end - i);
+            else discardToken();
+            i = end - 1;
+            start = end;
+            continue;
+        }
+
+        if (cls & CH_DELIM) {
+            if (i > start) finishToken(str + start, i - start);
+            start = i + 1;
+        } else if (cls & CH_EMO_LEAD) {
+            pushByte(c, cls);  // Lead without a tail is part of the word
+        } else {
+            // Ordinary bytes carry none of the class bits finishToken checks
+            size_t used = plainRun(str + i, length - i, words.data() + wordsUsed, currentWordLength,
+                                   lowered, currentLength);
+            i += used - 1;
+        }
+    }
+    if (length > start) finishToken(str + start, length - start);
+
+    return tokens;
+}
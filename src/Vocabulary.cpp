@@ -0,0 +1,201 @@
+#include "Vocabulary.h"
+#include <utility>
+
+namespace {
+    const size_t INITIAL_SLOTS = 1024;
+
+    inline uint32_t tagOf(uint64_t hash) {
+        return static_cast<uint32_t>(hash >> 32);
+    }
+}
+
+Vocabulary::Vocabulary() {
+    clear();
+}
+
+Vocabulary::Vocabulary(const Vocabulary& other) {
+    *this = other;
+}
+
+// Copies always own their storage
+Vocabulary& Vocabulary::operator=(const Vocabulary& other) {
+    if (this != &other) {
+        copyFrom(other.layout());
+    }
+    return *this;
+}
+
+void Vocabulary::copyFrom(const Layout& source) {
+    slots.assign(source.slots, source.slots + source.numSlots);
+    arena.assign(source.arena, source.arena + source.arenaBytes);
+    wordOffsets.assign(source.offsets, source.offsets + source.numWords);
+    wordLengths.assign(source.lengths, source.lengths + source.numWords);
+    wordCounts.assign(source.counts, source.counts + source.numWords);
+    attached = false;
+    syncViews();
+}
+
+void Vocabulary::clear() {
+    slots.assign(INITIAL_SLOTS, Slot{NOT_FOUND, 0});
+    arena.clear();
+    wordOffsets.clear();
+    wordLengths.clear();
+    wordCounts.clear();
+    attached = false;
+    syncViews();
+}
+
+// The views point into the vectors' buffers (or external ones), which move with them
+void Vocabulary::swap(Vocabulary& other) {
+    slots.swap(other.slots);
+    arena.swap(other.arena);
+    wordOffsets.swap(other.wordOffsets);
+    wordLengths.swap(other.wordLengths);
+    wordCounts.swap(other.wordCounts);
+    std::swap(slotView, other.slotView);
+    std::swap(mask, other.mask);
+    std::swap(arenaView, other.arenaView);
+    std::swap(arenaSize, other.arenaSize);
+    std::swap(offsetView, other.offsetView);
+    std::swap(lengthView, other.lengthView);
+    std::swap(countView, other.countView);
+    std::swap(numWords, other.numWords);
+    std::swap(attached, other.attached);
+}
+
+// Points the lookup views at the owned vectors
+void Vocabulary::syncViews() {
+    slotView = slots.data();
+    mask = slots.size() - 1;
+    arenaView = arena.data();
+    arenaSize = arena.size();
+    offsetView = wordOffsets.data();
+    lengthView = wordLengths.data();
+    countView = wordCounts.data();
+    numWords = wordCounts.size();
+}
+
+// Copy-on-write: an attached vocabulary is copied into owned storage
+void Vocabulary::makeWritable() {
+    if (attached) {
+        copyFrom(layout());  // Source is external, so the vectors are free to fill
+    }
+}
+
+Vocabulary::Layout Vocabulary::layout() const {
+    return Layout{slotView, mask + 1, arenaView, arenaSize,
+                  offsetView, lengthView, countView, numWords};
+}
+
+void Vocabulary::attach(const Layout& external) {
+    slots.clear();
+    arena.clear();
+    wordOffsets.clear();
+    wordLengths.clear();
+    wordCounts.clear();
+    slotView = external.slots;
+    mask = external.numSlots - 1;
+    arenaView = external.arena;
+    arenaSize = external.arenaBytes;
+    offsetView = external.offsets;
+    lengthView = external.lengths;
+    countView = external.counts;
+    numWords = external.numWords;
+    attached = true;
+}
+
+// Slot holding word, or the empty slot where it would be inserted
+size_t Vocabulary::probe(DSStringView word, uint64_t hash) const {
+    uint32_t tag = tagOf(hash);
+    size_t index = static_cast<size_t>(hash) & mask;
+    while (true) {
+        const Slot& slot = slotView[index];
+        if (slot.id == NOT_FOUND) {
+            return index;
+        }
+        if (slot.tag == tag && this->word(slot.id) == word) {
+            return index;
+        }
+        index = (index + 1) & mask;
+    }
+}
+
+uint32_t Vocabulary::find(DSStringView word, uint64_t hash) const {
+    return slotView[probe(word, hash)].id;
+}
+
+const WordCount* Vocabulary::lookup(DSStringView word) const {
+    uint32_t id = find(word);
+    return id != NOT_FOUND ? &countView[id] : nullptr;
+}
+
+WordCount& Vocabulary::counts(uint32_t id) {
+    makeWritable();
+    return wordCounts[id];
+}
+
+uint32_t Vocabulary::intern(DSStringView word, uint64_t hash) {
+    size_t index = probe(word, hash);
+    if (slotView[index].id != NOT_FOUND) {
+        return slotView[index].id;
+    }
+    makeWritable();
+
+    uint32_t id = static_cast<uint32_t>(wordCounts.size());
+    wordOffsets.push_back(static_cast<uint32_t>(arena.size()));
+    wordLengths.push_back(static_cast<uint32_t>(word.getLength()));
+    arena.insert(arena.end(), word.data(), word.data() + word.getLength());
+    wordCounts.push_back(WordCount{});
+    slots[index] = Slot{id, tagOf(hash)};
+
+    // Keep the load factor below 0.7 so probe sequences stay short
+    if (wordCounts.size() * 10 >= slots.size() * 7) {
+        grow();
+    }
+    syncViews();
+    return id;
+}
+
+void Vocabulary::add(DSStringView word, uint64_t hash, int pos, int neg) {
+    WordCount& count = counts(intern(word, hash));
+    count.pos += pos;
+    count.neg += neg;
+}
+
+void Vocabulary::merge(const Vocabulary& other) {
+    for (uint32_t id = 0; id < other.size(); id++) {
+        const WordCount& count = other.counts(id);
+        add(other.word(id), count.pos, count.neg);
+    }
+}
+
+DSStringView Vocabulary::word(uint32_t id) const {
+    return DSStringView(arenaView + offsetView[id], lengthView[id]);
+}
+
+void Vocabulary::grow() {
+    rebuildSlots(slots.size() * 2);
+}
+
+void Vocabulary::rebuildSlots(size_t numSlots) {
+    std::vector<Slot> rebuilt(numSlots, Slot{NOT_FOUND, 0});
+    size_t rebuiltMask = rebuilt.size() - 1;
+    for (uint32_t id = 0; id < wordCounts.size(); id++) {
+        DSStringView text(arena.data() + wordOffsets[id], wordLengths[id]);
+        uint64_t hash = hashWord(text);
+        size_t index = static_cast<size_t>(hash) & rebuiltMask;
+        while (rebuilt[index].id != NOT_FOUND) {
+            index = (index + 1) & rebuiltMask;
+        }
+        rebuilt[index] = Slot{id, tagOf(hash)};
+    }
+    slots.swap(rebuilt);
+}
+
+size_t Vocabulary::memoryUsage() const {
+    return slots.capacity() * sizeof(Slot) +
+           arena.capacity() +
+           wordOffsets.capacity() * sizeof(uint32_t) +
+           wordLengths.capacity() * sizeof(uint32_t) +
+           wordCounts.capacity() * sizeof(WordCount);
+}
@@ -1,52 +1,337 @@
 #include "SentimentClassifier.h"
+#include "ScoringServer.h"
+#include "Corpus.h"
+#include "Sweep.h"
+#include <algorithm>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Prints the supported command lines
+ * @param program Name the program was invoked as
+ */
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--threads N] [--hash-bits B | <prune options>] <training_file> "
+              << "<test_file> <test_sentiment_file> <predictions_file> <accuracy_file>\n"
+              << "       " << program << " train [--threads N] [--hash-bits B | <prune options>] "
+              << "<training_file> <model_file>\n"
+              << "       " << program << " predict [--threads N] <model_file> <test_file> <predictions_file>\n"
+              << "       " << program << " evaluate [--threads N] <test_sentiment_file> <predictions_file> "
+              << "<accuracy_file>\n"
+              << "       " << program << " update [--threads N] [--decay D] [<prune options>] "
+              << "<model_file> <batch_file> [<output_model_file>]\n"
+              << "       " << program << " serve [--threads N] [--hash-bits B | <prune options>] [--socket <path>] "
+              << "(--model <model_file> | --train <training_file>)\n"
+              << "       " << program << " compile-corpus <csv_file> <corpus_file>\n"
+              << "       " << program << " sweep [--threads N] <training_file> <test_file> <test_sentiment_file> "
+              << "<results_file> [<name>=<v1>,<v2>,...]...\n"
+              << "Prune options: [--min-count N] [--max-words K] [--sketch-bits B]\n"
+              << "Training and test files may be CSVs or corpora from compile-corpus\n"
+              << "Every command also accepts --stats <file> to write timings as JSON, and those that\n"
+              << "train or score --param <name>=<value> to change a tuning constant (see sweep)" << std::endl;
+}
+
+/**
+ * @brief Prints what pruned training kept and dropped
+ * @param classifier Classifier that has just trained with pruning on
+ * @param out Stream to print to
+ */
+static void printPruneReport(const SentimentClassifier& classifier, std::ostream& out) {
+    const PruneReport& report = classifier.getPruneReport();
+    out << "Pruned vocabulary: " << report.words << " words, " << report.modelBytes << " bytes ("
+        << report.droppedTokens << " rare-word tokens skipped, " << report.trimmedWords
+        << " words trimmed, sketch " << report.sketchBytes << " bytes)" << std::endl;
+}
 
 /**
  * @brief Main entry point for sentiment analysis program
- * 
+ *
  * Processes command line arguments and runs the sentiment classifier
  * through its training, prediction, and evaluation phases.
- * 
- * Expected arguments:
+ *
+ * Expected arguments (full pipeline):
  * 1. Training data file path
  * 2. Test data file path
  * 3. Test sentiment file path
  * 4. Predictions output file path
  * 5. Accuracy output file path
- * 
+ *
+ * Subcommands:
+ *   train <training_file> <model_file>                 Train and save a binary model
+ *   predict <model_file> <test_file> <predictions_file> Score with a saved model
+ *   evaluate <test_sentiment_file> <predictions_file> <accuracy_file>
+ *                                                       Score existing predictions
+ *   update <model_file> <batch_file> [<output_model_file>]
+ *                                                       Fold a labeled batch into a saved
+ *                                                       model (rewritten in place by default)
+ *   serve (--model <model_file> | --train <training_file>)
+ *                                                       Load or train once, then answer
+ *                                                       test-file rows from stdin (or the
+ *                                                       --socket) with "sentiment,id" lines
+ *   compile-corpus <csv_file> <corpus_file>
+ *                                                       Tokenize a training or test CSV once
+ *                                                       into a binary corpus, accepted in
+ *                                                       place of the CSV by every command
+ *   sweep <training_file> <test_file> <test_sentiment_file> <results_file> [<name>=<v1>,<v2>,...]...
+ *                                                       Tokenize once, then write the accuracy
+ *                                                       of every combination of the listed
+ *                                                       parameter values (see Sweep.h) as CSV
+ *
+ * Options:
+ *   --threads N      Number of worker threads (0 = all hardware threads, default 1)
+ *   --decay D        update: multiply existing counts by D in (0, 1] first (default 1)
+ *   --hash-bits B    Training from scratch: count hashed unigrams and bigrams in
+ *                    2^B counters (B in 10..30) instead of an exact vocabulary;
+ *                    the mode is saved with the model
+ *   --min-count N    Training: count only words seen at least N (<= 255) times in
+ *                    the file (estimated with a count-min sketch) or already in the model
+ *   --max-words K    Training: then keep the K words with the highest counts
+ *   --sketch-bits B  Width of the --min-count sketch: 4 rows of 2^B one-byte
+ *                    counters (default 22, 16 MiB); about 2^B >= 4 * distinct words
+ *   --socket <path>  serve: listen on a Unix domain socket instead of stdin/stdout
+ *   --param <name>=<value>
+ *                    Set a training or scoring constant (names as in sweep); repeatable.
+ *                    With sweep, the value used for parameters not being swept
+ *   --stats <file>   Write per-phase timings, model size, peak RSS and the
+ *                    per-tweet prediction latency histogram to file as JSON
+ *
  * @param argc Number of command line arguments
  * @param argv Array of command line arguments
  * @return 0 on success, 1 on error
  */
 int main(int argc, char** argv) {
+    // Optional subcommand comes first
+    std::string command;
+    int first = 1;
+    if (argc > 1 && (std::string(argv[1]) == "train" || std::string(argv[1]) == "predict" ||
+                     std::string(argv[1]) == "evaluate" || std::string(argv[1]) == "update" || std::string(argv[1]) == "serve" ||
+                     std::string(argv[1]) == "compile-corpus" || std::string(argv[1]) == "sweep")) {
+        command = argv[1];
+        first = 2;
+    }
+
+    // Separate options from positional arguments
+    std::vector<const char*> args;
+    unsigned threads = 1;
+    const char* socketPath = nullptr;
+    const char* modelFile = nullptr;
+    const char* trainingFile = nullptr;
+    const char* statsFile = nullptr;
+    double decay = 1.0;
+    unsigned hashBits = 0;
+    PruneOptions pruning;
+    ClassifierParams params;
+    bool badOption = false;
+    for (int i = first; i < argc; i++) {
+        std::string arg = argv[i];
+        if (command == "serve" && (arg == "--socket" || arg == "--model" || arg == "--train")) {
+            if (i + 1 >= argc) {
+                badOption = true;
+                break;
+            }
+            const char*& target = arg == "--socket" ? socketPath : arg == "--model" ? modelFile : trainingFile;
+            target = argv[++i];
+        } else if (command == "update" && arg == "--decay") {
+            if (i + 1 >= argc) {
+                badOption = true;
+                break;
+            }
+            try {
+                decay = std::stod(argv[++i]);
+            } catch (const std::exception&) {
+                badOption = true;
+            }
+        } else if ((command.empty() || command == "train" || command == "serve") && arg == "--hash-bits") {
+            if (i + 1 >= argc) {
+                badOption = true;
+                break;
+            }
+            try {
+                hashBits = static_cast<unsigned>(std::stoul(argv[++i]));
+            } catch (const std::exception&) {
+                badOption = true;
+            }
+        } else if (command != "predict" && command != "evaluate" && command != "compile-corpus" &&
+                   (arg == "--min-count" || arg == "--max-words" || arg == "--sketch-bits")) {
+            if (i + 1 >= argc) {
+                badOption = true;
+                break;
+            }
+            try {
+                unsigned long value = std::stoul(argv[++i]);
+                if (arg == "--min-count") pruning.minCount = static_cast<uint32_t>(value);
+                else if (arg == "--max-words") pruning.maxWords = value;
+                else pruning.sketchBits = static_cast<unsigned>(value);
+            } catch (const std::exception&) {
+                badOption = true;
+            }
+        } else if (command != "evaluate" && command != "compile-corpus" && arg == "--param") {
+            if (i + 1 >= argc) {
+                badOption = true;
+                break;
+            }
+            try {
+                parseClassifierParam(params, argv[++i]);
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << std::endl;
+                badOption = true;
+            }
+        } else if (arg == "--stats") {
+            if (i + 1 >= argc) {
+                badOption = true;
+                break;
+            }
+            statsFile = argv[++i];
+        } else if (arg == "--threads") {
+            if (i + 1 >= argc) {
+                badOption = true;
+                break;
+            }
+            try {
+                threads = static_cast<unsigned>(std::stoul(argv[++i]));
+            } catch (const std::exception&) {
+                badOption = true;
+            }
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+
     // Validate command line arguments
-    if (argc != 6) {
-        std::cerr << "Usage: " << argv[0] << " <training_file> <test_file> <test_sentiment_file> "
-                  << "<predictions_file> <accuracy_file>" << std::endl;
+    size_t expected = command == "train" ? 2 : command == "predict" ? 3 : command == "evaluate" ? 3 :
+                      command == "update" ? 2 : command == "serve" ? 0 : command == "compile-corpus" ? 2 : 5;
+    if (command == "serve" && (modelFile == nullptr) == (trainingFile == nullptr)) {
+        badOption = true;  // Exactly one model source
+    }
+    if (command == "update" && args.size() == 3) {
+        expected = 3;  // Optional output model
+    }
+    if (command == "sweep") {
+        expected = std::max<size_t>(4, args.size());  // Any number of parameter axes
+    }
+    if (badOption || args.size() != expected) {
+        printUsage(argv[0]);
         return 1;
     }
-    
+
     try {
         SentimentClassifier classifier;
-        
-        // Train the classifier on labeled data
-        std::cout << "Training classifier..." << std::endl;
-        classifier.train(argv[1]);
-        
-        // Make predictions on test data
-        std::cout << "Making predictions..." << std::endl;
-        classifier.predict(argv[2], argv[4]);
-        
-        // Evaluate prediction accuracy
-        std::cout << "Evaluating results..." << std::endl;
-        classifier.evaluatePredictions(argv[3], argv[4], argv[5]);
-        
-        std::cout << "Classification complete! Check " << argv[5] << " for results." << std::endl;
+        classifier.setThreads(threads);
+        if (hashBits > 0) {
+            classifier.setFeatureHashing(hashBits);
+        }
+        classifier.setPruning(pruning);
+        classifier.setParams(params);
+        RunStats stats;
+        uint64_t start = nowNanos();
+        if (statsFile) {
+            stats.threads = classifier.getThreads();
+            classifier.setStats(&stats);
+        }
+
+        if (command == "train") {
+            std::cout << "Training classifier..." << std::endl;
+            classifier.train(args[0]);
+            if (classifier.isPruning()) printPruneReport(classifier, std::cout);
+            classifier.saveModel(args[1]);
+            std::cout << "Model written to " << args[1] << std::endl;
+        } else if (command == "predict") {
+            classifier.loadModel(args[0]);
+            std::cout << "Making predictions..." << std::endl;
+            classifier.predict(args[1], args[2]);
+            std::cout << "Predictions written to " << args[2] << std::endl;
+        } else if (command == "evaluate") {
+            classifier.evaluatePredictions(args[0], args[1], args[2]);
+            std::cout << "Results written to " << args[2] << std::endl;
+        } else if (command == "update") {
+            const char* output = args.size() == 3 ? args[2] : args[0];
+            classifier.loadModel(args[0]);
+            std::cout << "Updating model..." << std::endl;
+            classifier.update(args[1], decay);
+            if (classifier.isPruning()) printPruneReport(classifier, std::cout);
+            classifier.saveModel(output);
+            std::cout << "Model written to " << output << std::endl;
+        } else if (command == "compile-corpus") {
+            uint64_t compileStart = nowNanos();
+            CorpusSummary corpus = compileCorpus(args[0], args[1]);
+            if (statsFile) {
+                stats.addPhase("compile_corpus", compileStart, nowNanos(), corpus.tweets, corpus.bytes);
+            }
+            std::cout << "Corpus written to " << args[1] << " ("
+                      << (corpus.kind == CorpusKind::Training ? "training" : "test") << ", "
+                      << corpus.tweets << " tweets, " << corpus.tokens << " tokens, "
+                      << corpus.words << " words, " << corpus.bytes << " bytes)" << std::endl;
+        } else if (command == "sweep") {
+            std::vector<SweepAxis> axes;
+            for (size_t i = 4; i < args.size(); i++) {
+                axes.push_back(parseSweepAxis(args[i]));
+            }
+            std::vector<ClassifierParams> grid = expandGrid(params, axes);
+            std::cout << "Sweeping " << grid.size() << " settings..." << std::endl;
+            std::vector<SweepResult> results = classifier.sweep(args[0], args[1], args[2], grid);
+            std::ofstream out(args[3]);
+            writeSweepResults(results, out);
+            if (!out) {
+                throw std::runtime_error("Unable to write sweep results");
+            }
+            size_t best = 0;
+            for (size_t i = 1; i < results.size(); i++) {
+                if (results[i].accuracy() > results[best].accuracy()) best = i;
+            }
+            std::cout << "Best accuracy " << results[best].accuracy() << " (row " << best + 1
+                      << "); results written to " << args[3] << std::endl;
+        } else if (command == "serve") {
+            // stdout may be the response channel, so progress goes to stderr
+            if (modelFile) {
+                classifier.loadModel(modelFile);
+            } else {
+                std::cerr << "Training classifier..." << std::endl;
+                classifier.train(trainingFile);
+                if (classifier.isPruning()) printPruneReport(classifier, std::cerr);
+            }
+            classifier.freeze();
+
+            ScoringServer server(classifier, classifier.getThreads());
+            ScoringServer::installSignalHandlers();
+            if (socketPath) {
+                std::cerr << "Listening on " << socketPath << std::endl;
+                server.serveSocket(socketPath);
+            } else {
+                server.serveStream(0, 1);
+            }
+            server.report(std::cerr);
+        } else {
+            // Train the classifier on labeled data
+            std::cout << "Training classifier..." << std::endl;
+            classifier.train(args[0]);
+            if (classifier.isPruning()) printPruneReport(classifier, std::cout);
+
+            // Make predictions on test data
+            std::cout << "Making predictions..." << std::endl;
+            classifier.predict(args[1], args[3]);
+
+            // Evaluate prediction accuracy
+            std::cout << "Evaluating results..." << std::endl;
+            classifier.evaluatePredictions(args[2], args[3], args[4]);
+
+            std::cout << "Classification complete! Check " << args[4] << " for results." << std::endl;
+        }
+
+        if (statsFile) {
+            stats.addPhase("total", start, nowNanos());
+            std::ofstream out(statsFile);
+            if (!out.is_open()) {
+                throw std::runtime_error("Unable to open stats file");
+            }
+            stats.writeJson(out);
+        }
     }
     catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
     }
-    
+
     return 0;
-} 
\ No newline at end of file
+}
@@ -1,6 +1,31 @@
 #include "DSString.h"
+#include "Arena.h"
+#include <algorithm>
 #include <cassert>
+#include <cstring>
+#include <cstdlib>
 #include <iostream>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Counts every heap allocation made through operator new/new[]
+static size_t allocationCount = 0;
+
+void* operator new(size_t size) {
+    allocationCount++;
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) {
+    allocationCount++;
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
+}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { std::free(ptr); }
 
 /**
  * Tests all constructors: default, c-string, and copy constructor
@@ -89,6 +114,216 @@ void testEdgeCases() {
     std::cout << "Edge case tests passed!" << std::endl;
 }
 
+/**
+ * Tests move construction and move assignment for inline and heap strings
+ * Verifies contents are transferred and the source is left empty
+ */
+void testMoveSemantics() {
+    DSString shortStr("token");
+    DSString moved(std::move(shortStr));
+    assert(strcmp(moved.c_str(), "token") == 0);
+    assert(shortStr.getLength() == 0);
+    assert(strcmp(shortStr.c_str(), "") == 0);
+    
+    std::string longStr(100, 'x');
+    DSString longSrc(longStr.c_str());
+    const char* buffer = longSrc.c_str();
+    DSString longMoved(std::move(longSrc));
+    assert(longMoved.c_str() == buffer);  // Heap buffer was stolen, not copied
+    assert(longMoved.getLength() == 100);
+    assert(longSrc.getLength() == 0);
+    
+    DSString target("old value that is long enough for the heap");
+    target = std::move(longMoved);
+    assert(target.c_str() == buffer);
+    target = std::move(moved);
+    assert(strcmp(target.c_str(), "token") == 0);
+    
+    // Source stays usable after being moved from
+    moved = DSString("again");
+    assert(strcmp(moved.c_str(), "again") == 0);
+    
+    std::cout << "Move semantics tests passed!" << std::endl;
+}
+
+/**
+ * Tests small-string optimization by counting heap allocations
+ * Short strings (<= SSO_CAPACITY) and moves must not allocate
+ */
+void testAllocations() {
+    size_t before = allocationCount;
+    {
+        DSString empty;
+        DSString word("awesome");
+        DSString copy(word);
+        DSString joined = word + copy;  // 14 characters, still inline
+        DSString sub = joined.substring(0, 3);
+        DSString limit(std::string(DSString::SSO_CAPACITY, 'a').c_str());
+        assert(joined.getLength() == 14);
+        assert(limit.getLength() == DSString::SSO_CAPACITY);
+    }
+    assert(allocationCount == before);
+    
+    // Tokenizer pattern: push_back of temporaries into a reserved vector
+    std::vector<DSString> tokens;
+    tokens.reserve(64);
+    const char* words[] = {"i", "love", "this", "new", "phone", ":)", "!!!", "can't", "wait"};
+    before = allocationCount;
+    for (int round = 0; round < 7; round++) {
+        for (const char* w : words) {
+            tokens.push_back(DSString(w));
+        }
+    }
+    assert(allocationCount == before);
+    
+    // Long strings allocate once; moving them does not allocate again
+    std::string longStr(64, 'z');
+    before = allocationCount;
+    DSString longWord(longStr.c_str());
+    assert(allocationCount - before == 1);
+    DSString stolen(std::move(longWord));
+    DSString assigned;
+    assigned = std::move(stolen);
+    assert(allocationCount - before == 1);
+    
+    std::cout << "Allocation tests passed!" << std::endl;
+}
+
+/**
+ * Tests DSStringView: comparison and hashing against DSString, substrings, search
+ * Verifies views never allocate and agree with the owning string type
+ */
+void testStringView() {
+    const char* tweet = "i love it :) !!!";
+    DSString owned("love");
+    
+    size_t before = allocationCount;
+    DSStringView word(tweet + 2, 4);
+    assert(word == owned);
+    assert(DSStringView(owned) == word);
+    assert(word == "love");
+    assert(word != DSStringView(tweet, 4));
+    assert(std::hash<DSStringView>()(word) == std::hash<DSString>()(owned));
+    
+    DSStringView all(tweet);
+    assert(all.getLength() == 16);
+    assert(all.contains(":)"));
+    assert(all.contains('!'));
+    assert(!all.contains(":("));
+    assert(all.substring(10, 2) == ":)");
+    assert(all.substring(14, 100) == "!!");
+    assert(all.substring(100, 1).empty());
+    assert(allocationCount == before);
+    
+    DSString copy = word.toString();
+    assert(strcmp(copy.c_str(), "love") == 0);
+    
+    std::cout << "String view tests passed!" << std::endl;
+}
+
+/**
+ * Tests the DSString allocator hook with a per-tweet Arena
+ * Verifies that long strings stop allocating once the arena is warm, that each
+ * string is released through the allocator it came from, and that reset reuses blocks
+ */
+void testArenaAllocator() {
+    const char* longText = "this tweet is far too long for the inline buffer";
+    Arena arena(256);
+    
+    // First tweet warms the arena up; later ones must not touch the heap
+    for (int tweet = 0; tweet < 3; tweet++) {
+        size_t before = allocationCount;
+        {
+            ArenaScope scope(arena);
+            std::vector<DSString, ArenaAllocator<DSString>> words{ArenaAllocator<DSString>(arena)};
+            words.reserve(32);
+            for (int i = 0; i < 32; i++) {
+                words.push_back(DSString(longText));
+            }
+            DSString joined = words[0] + words[1];
+            assert(joined.getLength() == 2 * strlen(longText));
+            assert(strcmp(words[31].c_str(), longText) == 0);
+            assert(arena.bytesUsed() > 32 * strlen(longText));
+        }
+        assert(arena.bytesUsed() == 0);
+        if (tweet > 0) {
+            assert(allocationCount == before);
+        }
+    }
+    size_t blocks = arena.blockCount();
+    
+    // A heap string moved out of a scope keeps freeing through operator new,
+    // and a string made inside the scope is released into its arena
+    DSString heapString(longText);
+    {
+        ArenaScope scope(arena);
+        DSString moved(std::move(heapString));
+        DSString fromArena(longText);
+        DSString assigned;
+        assigned = std::move(fromArena);
+        heapString = std::move(moved);
+    }
+    assert(strcmp(heapString.c_str(), longText) == 0);
+    assert(arena.blockCount() == blocks);
+    
+    // Oversized requests get a block of their own and are reused after reset
+    size_t before = allocationCount;
+    char* big = arena.allocateArray<char>(10000);
+    big[9999] = 'x';
+    arena.reset();
+    assert(arena.allocateArray<char>(10000) != nullptr);
+    assert(allocationCount - before <= 2);
+    arena.reset();
+    
+    std::cout << "Arena allocator tests passed!" << std::endl;
+}
+
+/**
+ * Tests the word-at-a-time hash and the hash cached by DSString
+ * Covers every load pattern (0, 1-3, 4-7, 8-16 and over 16 bytes), checks that
+ * copies and moves keep the cached value and that writing a character drops it
+ */
+void testHash() {
+    // Every prefix length hashes differently and equals the view hash
+    const char* text = "abcdefghijklmnopqrstuvwxyz0123456789ABCDEFGHIJKLMNOP";
+    std::vector<size_t> hashes;
+    for (size_t len = 0; len <= strlen(text); len++) {
+        DSString prefix(text, len);
+        assert(prefix.hash() == std::hash<DSStringView>()(DSStringView(text, len)));
+        assert(prefix.hash() == std::hash<DSString>()(prefix));
+        hashes.push_back(prefix.hash());
+    }
+    std::sort(hashes.begin(), hashes.end());
+    assert(std::adjacent_find(hashes.begin(), hashes.end()) == hashes.end());
+    
+    // A change to any single byte changes the hash
+    for (size_t len : {3, 7, 8, 16, 17, 40}) {
+        for (size_t i = 0; i < len; i++) {
+            DSString changed(text, len);
+            size_t original = changed.hash();
+            changed[i] = '#';
+            assert(changed.hash() != original);
+            assert(changed.hash() == std::hash<DSStringView>()(DSStringView(changed)));
+        }
+    }
+    
+    // The cache follows the contents through copies, moves and assignment
+    DSString word("wonderful");
+    size_t hash = word.hash();
+    DSString copy(word);
+    assert(copy.hash() == hash);
+    DSString moved(std::move(copy));
+    assert(moved.hash() == hash);
+    assert(copy.hash() == DSString().hash());
+    DSString other("awful");
+    other = moved;
+    assert(other.hash() == hash);
+    other = DSString("awful");
+    assert(other.hash() == std::hash<DSStringView>()(DSStringView("awful")));
+    
+    std::cout << "Hash tests passed!" << std::endl;
+}
+
 int main() {
     try {
         std::cout << "Starting DSString tests..." << std::endl;
@@ -96,6 +331,11 @@ int main() {
         testOperators();
         testUtilityFunctions();
         testEdgeCases();
+        testMoveSemantics();
+        testAllocations();
+        testStringView();
+        testArenaAllocator();
+        testHash();
         std::cout << "\nAll tests passed successfully!" << std::endl;
     }
     catch (const std::exception& e) {
@@ -0,0 +1,172 @@
+#include "Vocabulary.h"
+#include "Tokenizer.h"
+#include "CsvReader.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Collision and distribution checks for hashCharacters on real keys:
+ * the normalized words of the bundled datasets and numeric tweet ids.
+ * Bounds are several standard deviations wide, so an ideal hash passes
+ * with overwhelming probability and a weak one does not: DJB2, even with a
+ * 64-bit finalizer, maps most of the 1-3 byte short keys onto each other.
+ */
+
+// Distinct normalized words of the datasets, in first-seen order
+Vocabulary loadVocabulary(const char* trainPath, const char* testPath) {
+    Vocabulary vocabulary;
+    Tokenizer tokenizer;
+    struct Input { const char* path; size_t textField; };
+    for (Input input : {Input{trainPath, 5}, Input{testPath, 4}}) {
+        MappedFile file(input.path);
+        assert(file.is_open());
+        CsvReader reader(file);
+        CsvField line;
+        reader.nextLine(line);
+        while (reader.nextLine(line)) {
+            CsvField fields[6];
+            CsvReader::splitFields(line, fields, input.textField + 1);
+            CsvField text = fields[input.textField].unquoted();
+            for (const Token& token : tokenizer.run(DSStringView(text.data, text.length))) {
+                vocabulary.intern(token.raw);
+                if (!token.word.empty()) vocabulary.intern(token.word);
+            }
+        }
+    }
+    return vocabulary;
+}
+
+// Number of pairs sharing a value (sorts values)
+size_t collidingPairs(std::vector<uint64_t>& values) {
+    std::sort(values.begin(), values.end());
+    size_t pairs = 0;
+    for (size_t i = 0, run = 1; i + 1 <= values.size(); i++) {
+        if (i + 1 < values.size() && values[i + 1] == values[i]) {
+            run++;
+        } else {
+            pairs += run * (run - 1) / 2;
+            run = 1;
+        }
+    }
+    return pairs;
+}
+
+/**
+ * Checks a set of distinct-key hashes: no full 64-bit collisions, about the
+ * expected number of 32-bit tag collisions, every output bit set about half
+ * the time, and an even spread over buckets taken from the low bits (slot
+ * index) and from the high bits (tag)
+ */
+void checkHashes(const char* name, const std::vector<uint64_t>& hashes) {
+    double n = static_cast<double>(hashes.size());
+
+    std::vector<uint64_t> full = hashes;
+    assert(collidingPairs(full) == 0);
+
+    std::vector<uint64_t> tags;
+    for (uint64_t hash : hashes) tags.push_back(hash >> 32);
+    double expectedTagPairs = n * (n - 1) / 2 / 4294967296.0;
+    size_t tagPairs = collidingPairs(tags);
+    assert(tagPairs <= expectedTagPairs + 6 * std::sqrt(expectedTagPairs) + 3);
+
+    double bitSigma = std::sqrt(n) / 2;
+    for (int bit = 0; bit < 64; bit++) {
+        size_t set = 0;
+        for (uint64_t hash : hashes) set += (hash >> bit) & 1;
+        assert(std::abs(static_cast<double>(set) - n / 2) < 6 * bitSigma);
+    }
+
+    // About 8 keys per bucket; chi-square has B - 1 degrees of freedom
+    size_t bits = 1;
+    while ((size_t(1) << (bits + 1)) * 8 <= hashes.size()) bits++;
+    size_t buckets = size_t(1) << bits;
+    double expected = n / static_cast<double>(buckets);
+    double limit = (buckets - 1) + 6 * std::sqrt(2.0 * (buckets - 1));
+    double chiLow = 0;
+    double chiHigh = 0;
+    std::vector<size_t> low(buckets), high(buckets);
+    for (uint64_t hash : hashes) {
+        low[hash & (buckets - 1)]++;
+        high[hash >> (64 - bits)]++;
+    }
+    for (size_t b = 0; b < buckets; b++) {
+        chiLow += (low[b] - expected) * (low[b] - expected) / expected;
+        chiHigh += (high[b] - expected) * (high[b] - expected) / expected;
+    }
+    assert(chiLow < limit);
+    assert(chiHigh < limit);
+
+    std::cout << name << ": " << hashes.size() << " keys, " << tagPairs << " tag collisions (expected "
+              << expectedTagPairs << "), chi-square " << chiLow << " / " << chiHigh << " over "
+              << buckets << " buckets (limit " << limit << ")" << std::endl;
+}
+
+/**
+ * Tests the words of the datasets, and that the vocabulary's probe
+ * sequences stay short with them
+ */
+void testVocabulary() {
+    Vocabulary vocabulary = loadVocabulary("data/train_dataset_20k.csv", "data/test_dataset_10k.csv");
+    assert(vocabulary.size() > 10000);
+
+    std::vector<uint64_t> hashes;
+    for (uint32_t id = 0; id < vocabulary.size(); id++) {
+        hashes.push_back(Vocabulary::hashWord(vocabulary.word(id)));
+    }
+    checkHashes("Dataset words", hashes);
+
+    // Linear probing at the table's load factor: mean probe length near 1.5
+    Vocabulary::Layout layout = vocabulary.layout();
+    size_t probes = 0;
+    for (uint32_t id = 0; id < vocabulary.size(); id++) {
+        size_t index = static_cast<size_t>(hashes[id]) & (layout.numSlots - 1);
+        probes++;
+        while (layout.slots[index].id != id) {
+            index = (index + 1) & (layout.numSlots - 1);
+            probes++;
+        }
+    }
+    double meanProbes = static_cast<double>(probes) / vocabulary.size();
+    assert(meanProbes < 2.0);
+    std::cout << "Mean probe length " << meanProbes << " over " << layout.numSlots << " slots" << std::endl;
+}
+
+/**
+ * Tests sequential numeric ids, the keys of the evaluation join
+ */
+void testNumericIds() {
+    std::vector<uint64_t> hashes;
+    for (uint64_t id = 1467810369; id < 1467810369 + 1000000; id++) {
+        std::string text = std::to_string(id);
+        hashes.push_back(hashCharacters(text.data(), text.length()));
+    }
+    checkHashes("Numeric ids", hashes);
+}
+
+/**
+ * Tests short keys differing only in one position
+ */
+void testShortKeys() {
+    std::vector<uint64_t> hashes;
+    for (int length = 1; length <= 3; length++) {
+        for (int value = 0; value < (1 << (8 * length)) && value < (1 << 20); value++) {
+            char key[3] = {static_cast<char>(value), static_cast<char>(value >> 8), static_cast<char>(value >> 16)};
+            hashes.push_back(hashCharacters(key, length));
+        }
+    }
+    checkHashes("Short keys", hashes);
+}
+
+int main() {
+    std::cout << "Starting hash tests..." << std::endl;
+    testVocabulary();
+    testNumericIds();
+    testShortKeys();
+    std::cout << "\nAll tests passed successfully!" << std::endl;
+    return 0;
+}
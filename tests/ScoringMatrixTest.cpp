@@ -0,0 +1,100 @@
+#include "SentimentClassifier.h"
+#include "ScoringMatrix.h"
+#include "CsvReader.h"
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+/**
+ * Checks batch scoring (classifyBatch over a ScoringMatrix) against classify()
+ * tweet by tweet, for every kernel and for parameters that reach each branch
+ * of the scoring rule, on the bundled test set and hand-picked edge cases.
+ */
+
+// Tweet texts of the bundled test set plus edge cases; they stay valid while file is mapped
+std::vector<DSStringView> loadTexts(const MappedFile& file) {
+    static const char* const cases[] = {
+        "", "the", "not", "not not", "not good", "good not", "never :(", "love :) :) :( hate",
+        "LOVE LOVE LOVE", "hate hate not", "zzqqxx unseenword", "no :)", "awesome!!! terrible???",
+        "love sad sad not", "hate happy happy not", "great bad not", "worst fun fun fun never"
+    };
+    std::vector<DSStringView> texts(std::begin(cases), std::end(cases));
+    CsvReader reader(file);
+    CsvField line;
+    reader.nextLine(line);
+    while (reader.nextLine(line)) {
+        CsvField fields[5];
+        CsvReader::splitFields(line, fields, 5);
+        CsvField text = fields[4].unquoted();
+        texts.push_back(DSStringView(text.data, text.length));
+    }
+    return texts;
+}
+
+/**
+ * Batch sizes 1 to 9 (full and partial groups of four rows) on the first 500
+ * texts, then all texts at once
+ */
+void checkBatches(const SentimentClassifier& classifier, const std::vector<DSStringView>& texts,
+                  Tokenizer::Isa isa) {
+    std::vector<int> expected(texts.size());
+    for (size_t i = 0; i < texts.size(); i++) {
+        expected[i] = classifier.classify(texts[i]);
+    }
+    ScoringMatrix matrix;
+    std::vector<int> results(texts.size(), -1);
+    const size_t prefix = std::min<size_t>(500, texts.size());
+    for (size_t batch = 1; batch <= 9; batch++) {
+        for (size_t first = 0; first < prefix; first += batch) {
+            size_t count = std::min(batch, prefix - first);
+            classifier.classifyBatch(texts.data() + first, count, results.data() + first, matrix, isa);
+        }
+        assert(std::equal(expected.begin(), expected.begin() + prefix, results.begin()));
+    }
+    classifier.classifyBatch(texts.data(), texts.size(), results.data(), matrix, isa);
+    assert(results == expected);
+    assert(matrix.numRows() == texts.size() || classifier.getFeatures().enabled());
+}
+
+int main() {
+    std::cout << "Starting ScoringMatrix tests..." << std::endl;
+    MappedFile testFile("data/test_dataset_10k.csv");
+    assert(testFile.is_open());
+    std::vector<DSStringView> texts = loadTexts(testFile);
+
+    SentimentClassifier classifier;
+    classifier.train("data/train_dataset_20k.csv");
+    classifier.freeze();
+    SentimentClassifier hashed;
+    hashed.setFeatureHashing(16);
+    hashed.train("data/train_dataset_20k.csv");
+    hashed.freeze();
+
+    std::vector<ClassifierParams> settings(6);
+    settings[1].clarity = -1;         // Unseen words count as clear
+    settings[2].clarity = 0;          // Words with equal weights do not
+    settings[3].confidence = 0;       // Only exact ties fall back
+    settings[4].confidence = 10;      // Every tweet falls back to strong indicators
+    settings[5].strongBoost = 0.1;
+    settings[5].strongMultiplier = 3;
+    settings[5].emoticonBoost = 2;
+
+    for (Tokenizer::Isa isa : {Tokenizer::Isa::Scalar, Tokenizer::Isa::AVX2}) {
+        if (!Tokenizer::isSupported(isa)) {
+            std::cout << "Skipping " << Tokenizer::isaName(isa) << " (not supported)" << std::endl;
+            continue;
+        }
+        std::cout << "Kernel: " << Tokenizer::isaName(isa) << std::endl;
+        for (const ClassifierParams& params : settings) {
+            classifier.setParams(params);
+            checkBatches(classifier, texts, isa);
+        }
+        checkBatches(hashed, texts, isa);
+        std::cout << "Matched classify() on " << texts.size() << " tweets" << std::endl;
+    }
+    std::cout << "\nAll tests passed successfully!" << std::endl;
+    return 0;
+}
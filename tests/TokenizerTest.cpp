@@ -0,0 +1,150 @@
+#include "SentimentClassifier.h"
+#include "Tokenizer.h"
+#include "Lexicon.h"
+#include "CsvReader.h"
+#include "Arena.h"
+#include <cassert>
+#include <cctype>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Checks the fused Tokenizer against the reference path:
+ * tokenize() + preprocessWord() + lexicon lookups on the lowercased token
+ * The reference strings of each tweet live in an arena that is reset afterwards.
+ */
+void checkAgainstReference(const SentimentClassifier& classifier, Tokenizer& tokenizer, DSStringView text) {
+    static Arena arena;
+    ArenaScope scope(arena);
+    std::vector<DSStringView> expected = classifier.tokenize(text);
+    const std::vector<Token>& actual = tokenizer.run(text);
+    assert(actual.size() == expected.size());
+    
+    for (size_t i = 0; i < expected.size(); i++) {
+        const Token& token = actual[i];
+        assert(token.raw == expected[i]);
+        assert(token.raw.data() == expected[i].data());
+        
+        DSString word = classifier.preprocessWord(expected[i]);
+        assert(token.word == word);
+        
+        std::string lower(expected[i].data(), expected[i].getLength());
+        for (char& c : lower) c = static_cast<char>(::tolower(c));
+        assert(token.rawFlags == lexiconFlags(DSStringView(lower.data(), lower.length())));
+        
+        const LexiconEntry* entry = lookupLexicon(word);
+        assert(token.wordFlags == (entry ? entry->flags : 0));
+        assert(token.trainWeight == (entry ? entry->trainWeight : 1));
+        
+        DSStringView w = word;
+        bool emphatic = w.contains("!!!") || w.contains("???");
+        bool smile = expected[i].contains(":)") || expected[i].contains(":D");
+        bool frown = expected[i].contains(":(");
+        assert(((token.marks & TOKEN_EMPHATIC) != 0) == emphatic);
+        assert(((token.marks & TOKEN_SMILE) != 0) == smile);
+        assert(((token.marks & TOKEN_FROWN) != 0) == frown);
+    }
+}
+
+/**
+ * Tests hand-picked edge cases: emoticons, punctuation runs, stop words, case
+ */
+void testEdgeCases(const SentimentClassifier& classifier, Tokenizer& tokenizer) {
+    const char* cases[] = {
+        "", " ", "a", "I LOVE it :) :D =( ;P ;D", "Not good!!! really???", "...!?",
+        "wait.", "don't DOESN'T didn't", ":-) :-( :'( <3 :/", "x:)y", "::))", "!!!a!!!",
+        "THE the The tHe", "tab\tsep,comma\nnewline", "caf\xc3\xa9 na\xefve \xff\x80",
+        "averyveryveryveryverylongtokenthatkeepsgoingandgoingandgoing!!",
+        "Soooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooooo GOOOOOOOOD!!!"
+    };
+    for (const char* text : cases) {
+        checkAgainstReference(classifier, tokenizer, DSStringView(text));
+    }
+    
+    const std::vector<Token>& tokens = tokenizer.run(DSStringView("The movie was AWESOME :)"));
+    assert(tokens.size() == 5);
+    assert(tokens[0].word.empty());               // Stop word
+    assert(tokens[3].word == "awesome");
+    assert(tokens[3].rawFlags & LEX_SCORE_POSITIVE);
+    assert(tokens[3].trainWeight == 3);
+    assert(tokens[4].marks & TOKEN_SMILE);
+    
+    std::cout << "Edge case tests passed!" << std::endl;
+}
+
+/**
+ * Tests random strings drawn from the characters the tokenizer treats specially
+ */
+void testRandomText(const SentimentClassifier& classifier, Tokenizer& tokenizer) {
+    const char alphabet[] = " ,\t\n!?.:=;)(DPdpaZ'-<3/|\x80\xff";
+    std::srand(12345);
+    for (int round = 0; round < 20000; round++) {
+        std::string text(static_cast<size_t>(std::rand() % 40), ' ');
+        for (char& c : text) c = alphabet[std::rand() % (sizeof(alphabet) - 1)];
+        checkAgainstReference(classifier, tokenizer, DSStringView(text.data(), text.length()));
+    }
+    std::cout << "Random text tests passed!" << std::endl;
+}
+
+/**
+ * Tests every tweet of a bundled dataset
+ */
+void testDataset(const SentimentClassifier& classifier, Tokenizer& tokenizer,
+                 const char* path, size_t textField) {
+    MappedFile file(path);
+    assert(file.is_open());
+    CsvReader reader(file);
+    CsvField line;
+    reader.nextLine(line);
+    size_t rows = 0;
+    while (reader.nextLine(line)) {
+        CsvField fields[6];
+        CsvReader::splitFields(line, fields, textField + 1);
+        CsvField text = fields[textField].unquoted();
+        checkAgainstReference(classifier, tokenizer, DSStringView(text.data, text.length));
+        rows++;
+    }
+    assert(rows > 0);
+    std::cout << "Dataset " << path << " matched (" << rows << " tweets)" << std::endl;
+}
+
+/**
+ * Tests long words and runs that straddle the 16/32-byte kernel blocks
+ */
+void testBlockBoundaries(const SentimentClassifier& classifier, Tokenizer& tokenizer) {
+    const char* pieces[] = {"a", "Bc", "x1", "\xc3\xa9", "-", ":", "=", "!", ".", " ", ",", ":)", ";P", "Q"};
+    std::srand(777);
+    for (int round = 0; round < 5000; round++) {
+        std::string text;
+        while (text.length() < static_cast<size_t>(std::rand() % 200)) {
+            int repeat = 1 + std::rand() % 40;
+            const char* piece = pieces[std::rand() % (sizeof(pieces) / sizeof(pieces[0]))];
+            for (int r = 0; r < repeat; r++) text += piece;
+        }
+        checkAgainstReference(classifier, tokenizer, DSStringView(text.data(), text.length()));
+    }
+    std::cout << "Block boundary tests passed!" << std::endl;
+}
+
+int main() {
+    SentimentClassifier classifier;
+    std::cout << "Starting Tokenizer tests..." << std::endl;
+    for (Tokenizer::Isa isa : {Tokenizer::Isa::Scalar, Tokenizer::Isa::SSE2, Tokenizer::Isa::AVX2}) {
+        if (!Tokenizer::isSupported(isa)) {
+            std::cout << "Skipping " << Tokenizer::isaName(isa) << " (not supported)" << std::endl;
+            continue;
+        }
+        Tokenizer tokenizer(isa);
+        assert(tokenizer.getIsa() == isa);
+        std::cout << "Kernel: " << Tokenizer::isaName(isa) << std::endl;
+        testEdgeCases(classifier, tokenizer);
+        testRandomText(classifier, tokenizer);
+        testBlockBoundaries(classifier, tokenizer);
+        testDataset(classifier, tokenizer, "data/train_dataset_20k.csv", 5);
+        testDataset(classifier, tokenizer, "data/test_dataset_10k.csv", 4);
+    }
+    std::cout << "\nAll tests passed successfully!" << std::endl;
+    return 0;
+}
@@ -0,0 +1,359 @@
+#include "CsvReader.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Writes synthetic tweets in the exact format of the bundled datasets, for
+// measuring how train, predict and evaluate scale past their 20k/10k rows.
+//
+// Usage: generate_dataset [options] <seed_train.csv> train <rows> <out.csv>
+//        generate_dataset [options] <seed_train.csv> test <rows> <test.csv> <truth.csv>
+//   --seed N       Random seed (default 1); the output depends only on the
+//                  seed, the mode, the options and the seed file
+//   --zipf S       Exponent of the word rank distribution (default 1.0)
+//   --new-words P  Share of tokens that are novel words (default 0.02)
+//   --first-id ID  Id of the first row (default 1000000000); ids then count up
+//
+// The seed file (a training CSV) provides the vocabulary: its space-separated
+// tokens, kept verbatim with their case, punctuation and emoticons, ranked by
+// frequency. A row draws its label with the seed's positive share, its length
+// from the seed's tokens-per-tweet, and each token with probability
+//   P(word | label) ~ 1 / (rank + 1)^S * (count[label] + 1) / (count + 2)
+// so frequent words stay frequent and keep the sentiment they had in the
+// seed. A novel word is a seed word plus a letter suffix, its id drawn with
+// density 1/k from [1, 2^32): the vocabulary keeps growing with the row
+// count, more slowly than linearly, like the handles and typos of real data.
+// Users are drawn from the seed's and dates from its April-June 2009 range.
+
+namespace {
+    // SplitMix64: fast, and the same stream on every platform (unlike the
+    // distributions of <random>)
+    class Random {
+    public:
+        explicit Random(uint64_t seed) : state(seed) {}
+        uint64_t next() {
+            uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+        // Uniform in [0, 1)
+        double uniform() { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+        // Uniform in [0, n)
+        size_t below(size_t n) { return static_cast<size_t>(uniform() * static_cast<double>(n)); }
+
+    private:
+        uint64_t state;
+    };
+
+    // Walker's alias method: O(1) draws from a fixed discrete distribution
+    class AliasTable {
+    public:
+        explicit AliasTable(const std::vector<double>& weights)
+            : probability(weights.size()), alias(weights.size()) {
+            double total = 0;
+            for (double weight : weights) total += weight;
+            std::vector<double> scaled(weights.size());
+            std::vector<uint32_t> small, large;
+            for (size_t i = 0; i < weights.size(); i++) {
+                scaled[i] = weights[i] * static_cast<double>(weights.size()) / total;
+                (scaled[i] < 1 ? small : large).push_back(static_cast<uint32_t>(i));
+            }
+            while (!small.empty() && !large.empty()) {
+                uint32_t less = small.back();
+                uint32_t more = large.back();
+                small.pop_back();
+                probability[less] = scaled[less];
+                alias[less] = more;
+                scaled[more] -= 1 - scaled[less];
+                if (scaled[more] < 1) {
+                    large.pop_back();
+                    small.push_back(more);
+                }
+            }
+            // Whatever is left is 1 up to rounding
+            for (uint32_t i : small) probability[i] = 1;
+            for (uint32_t i : large) probability[i] = 1;
+        }
+
+        uint32_t draw(Random& random) const {
+            size_t column = random.below(probability.size());
+            return random.uniform() < probability[column] ? static_cast<uint32_t>(column) : alias[column];
+        }
+
+    private:
+        std::vector<double> probability;
+        std::vector<uint32_t> alias;
+    };
+
+    struct SeedWord {
+        std::string text;
+        uint64_t count[2] = {0, 0};  // Occurrences in negative and positive tweets
+    };
+
+    // What the generator keeps of the seed file
+    struct Seed {
+        std::vector<SeedWord> words;       // By rank, most frequent first
+        std::vector<uint32_t> lengths;     // Tokens per tweet, one entry per tweet
+        std::vector<std::string> users;
+        double positiveShare = 0.5;
+    };
+
+    Seed readSeed(const char* path) {
+        MappedFile file(path);
+        if (!file.is_open()) {
+            throw std::runtime_error(std::string("Unable to open ") + path);
+        }
+        Seed seed;
+        std::unordered_map<std::string, size_t> index;
+        std::unordered_map<std::string, bool> users;
+        uint64_t positive = 0;
+        CsvReader reader(file);
+        CsvField line;
+        reader.nextLine(line);  // Header
+        while (reader.nextLine(line)) {
+            if (line.trimmed().empty()) continue;
+            // Sentiment, id, date, query, user, text
+            CsvField fields[6];
+            CsvReader::splitFields(line, fields, 6);
+            int label = fields[0].equals("4") ? 1 : 0;
+            positive += label;
+            if (users.emplace(fields[4].str(), true).second) {
+                seed.users.push_back(fields[4].str());
+            }
+            CsvField text = fields[5].unquoted();
+            uint32_t length = 0;
+            size_t start = 0;
+            for (size_t i = 0; i <= text.length; i++) {
+                if (i < text.length && text.data[i] != ' ') continue;
+                std::string token(text.data + start, i - start);
+                start = i + 1;
+                // Quotes would need escaping, and CR/LF would split the row
+                if (token.empty() || token.find_first_of("\"\r\n") != std::string::npos) continue;
+                auto inserted = index.emplace(token, seed.words.size());
+                if (inserted.second) {
+                    seed.words.push_back(SeedWord{token, {0, 0}});
+                }
+                seed.words[inserted.first->second].count[label]++;
+                length++;
+            }
+            seed.lengths.push_back(length);
+        }
+        if (seed.lengths.empty() || seed.words.empty()) {
+            throw std::runtime_error(std::string("No tweets in ") + path);
+        }
+        seed.positiveShare = static_cast<double>(positive) / static_cast<double>(seed.lengths.size());
+        // Ties keep first-seen order
+        std::stable_sort(seed.words.begin(), seed.words.end(), [](const SeedWord& a, const SeedWord& b) {
+            return a.count[0] + a.count[1] > b.count[0] + b.count[1];
+        });
+        return seed;
+    }
+
+    struct Options {
+        uint64_t seed = 1;
+        double zipf = 1.0;
+        double newWords = 0.02;
+        uint64_t firstId = 1000000000;
+    };
+
+    // Twitter's date format, at a random second of 2009-04-06 (a Monday) .. 2009-06-30
+    void appendDate(std::string& out, Random& random) {
+        static const char* const DAYS[] = {"Mon", "Tue", "Wed", "Thu", "Fri", "Sat", "Sun"};
+        static const char* const MONTHS[] = {"Apr", "May", "Jun"};
+        static const int MONTH_DAYS[] = {30, 31, 30};
+        const int FIRST_DAY = 6;
+        int dayIndex = static_cast<int>(random.below(30 - FIRST_DAY + 1 + 31 + 30));
+        int second = static_cast<int>(random.below(24 * 3600));
+        int month = 0;
+        int day = FIRST_DAY + dayIndex;
+        while (day > MONTH_DAYS[month]) {
+            day -= MONTH_DAYS[month];
+            month++;
+        }
+        char buffer[40];
+        std::snprintf(buffer, sizeof(buffer), "%s %s %02d %02d:%02d:%02d PDT 2009", DAYS[dayIndex % 7],
+                      MONTHS[month], day, second / 3600, second / 60 % 60, second % 60);
+        out += buffer;
+    }
+
+    // Novel word k: seed word k mod V with k / V spelled in letters after it
+    void appendNovelWord(std::string& out, const Seed& seed, uint64_t k) {
+        out += seed.words[k % seed.words.size()].text;
+        for (uint64_t rest = k / seed.words.size() + 1; rest > 0; rest /= 26) {
+            out += static_cast<char>('a' + rest % 26);
+        }
+    }
+
+    class Generator {
+    public:
+        Generator(const Seed& seed, const Options& options, uint64_t stream)
+            : seed(seed), options(options), random(options.seed * 0x9e3779b97f4a7c15ULL + stream),
+              tables{AliasTable(labelWeights(0)), AliasTable(labelWeights(1))} {}
+
+        // Appends a tweet's text (quoted if it holds a comma, as in the seed) and returns its label
+        int appendTweet(std::string& text) {
+            int label = random.uniform() < seed.positiveShare ? 1 : 0;
+            uint32_t length = seed.lengths[random.below(seed.lengths.size())];
+            for (uint32_t i = 0; i < length; i++) {
+                if (i > 0) text += ' ';
+                if (random.uniform() < options.newWords) {
+                    // Density 1/k on [1, 2^32)
+                    uint64_t k = static_cast<uint64_t>(std::exp(random.uniform() * 32 * std::log(2.0)));
+                    appendNovelWord(text, seed, k);
+                } else {
+                    text += seed.words[tables[label].draw(random)].text;
+                }
+            }
+            return label;
+        }
+
+        void appendRowPrefix(std::string& out) {
+            appendDate(out, random);
+            out += ",NO_QUERY,";
+            out += seed.users[random.below(seed.users.size())];
+            out += ',';
+        }
+
+    private:
+        std::vector<double> labelWeights(int label) const {
+            std::vector<double> weights(seed.words.size());
+            for (size_t rank = 0; rank < weights.size(); rank++) {
+                const SeedWord& word = seed.words[rank];
+                double affinity = (word.count[label] + 1.0) / (word.count[0] + word.count[1] + 2.0);
+                weights[rank] = affinity / std::pow(static_cast<double>(rank + 1), options.zipf);
+            }
+            return weights;
+        }
+
+        const Seed& seed;
+        const Options& options;
+        Random random;
+        AliasTable tables[2];
+    };
+
+    // Buffered output that reports write failures
+    class Output {
+    public:
+        explicit Output(const char* path) : path(path), file(std::fopen(path, "wb")) {
+            if (!file) throw std::runtime_error(std::string("Unable to create ") + path);
+            buffer.reserve(BUFFER_BYTES + 4096);
+        }
+        ~Output() {
+            if (file) std::fclose(file);
+        }
+        std::string& text() { return buffer; }
+        void flushIfFull() {
+            if (buffer.size() >= BUFFER_BYTES) flush();
+        }
+        void close() {
+            flush();
+            if (std::fclose(file) != 0) {
+                file = nullptr;
+                throw std::runtime_error(std::string("Unable to write ") + path);
+            }
+            file = nullptr;
+        }
+
+    private:
+        static constexpr size_t BUFFER_BYTES = 1 << 20;
+        void flush() {
+            if (std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+                throw std::runtime_error(std::string("Unable to write ") + path);
+            }
+            buffer.clear();
+        }
+
+        const char* path;
+        std::FILE* file;
+        std::string buffer;
+    };
+
+    void appendText(std::string& out, const std::string& text) {
+        if (text.find(',') != std::string::npos) {
+            out += '"';
+            out += text;
+            out += '"';
+        } else {
+            out += text;
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    std::vector<const char*> args;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--seed" && hasValue) options.seed = std::stoull(argv[++i]);
+            else if (arg == "--zipf" && hasValue) options.zipf = std::stod(argv[++i]);
+            else if (arg == "--new-words" && hasValue) options.newWords = std::stod(argv[++i]);
+            else if (arg == "--first-id" && hasValue) options.firstId = std::stoull(argv[++i]);
+            else args.push_back(argv[i]);
+        }
+    } catch (const std::exception&) {
+        args.clear();
+    }
+    bool train = args.size() == 4 && std::string(args[1]) == "train";
+    bool test = args.size() == 5 && std::string(args[1]) == "test";
+    if ((!train && !test) || !(options.zipf >= 0) || !(options.newWords >= 0 && options.newWords <= 1)) {
+        std::cerr << "Usage: " << argv[0] << " [--seed N] [--zipf S] [--new-words P] [--first-id ID]"
+                  << " <seed_train.csv> train <rows> <out.csv>\n"
+                  << "       " << argv[0] << " [options] <seed_train.csv> test <rows> <test.csv> <truth.csv>"
+                  << std::endl;
+        return 1;
+    }
+
+    try {
+        uint64_t rows = std::stoull(args[2]);
+        Seed seed = readSeed(args[0]);
+        // Train and test draw different streams, so they share no tweets for one --seed
+        Generator generator(seed, options, train ? 0 : 1);
+        Output out(args[3]);
+        std::optional<Output> truth;
+        out.text() += train ? "Sentiment,id,Date,Query,User,Tweet\n" : "id,Date,Query,User,Tweet\n";
+        if (test) {
+            truth.emplace(args[4]);
+            truth->text() += "Sentiment,id\n";
+        }
+        std::string text;
+        for (uint64_t row = 0; row < rows; row++) {
+            text.clear();
+            int label = generator.appendTweet(text);
+            std::string id = std::to_string(options.firstId + row);
+            std::string& line = out.text();
+            if (train) {
+                line += label ? "4," : "0,";
+            }
+            line += id;
+            line += ',';
+            generator.appendRowPrefix(line);
+            appendText(line, text);
+            line += '\n';
+            out.flushIfFull();
+            if (test) {
+                std::string& truthLine = truth->text();
+                truthLine += label ? "4," : "0,";
+                truthLine += id;
+                truthLine += '\n';
+                truth->flushIfFull();
+            }
+        }
+        out.close();
+        if (truth) truth->close();
+        std::cerr << "Wrote " << rows << " rows (" << seed.words.size() << " seed words)" << std::endl;
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
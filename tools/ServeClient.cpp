@@ -0,0 +1,161 @@
+#include "CsvReader.h"
+#include "LatencyHistogram.h"
+#include <chrono>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// Replays a test file against `sentiment serve --socket <path>` and reports
+// throughput and the latency the client observed for each request.
+// Up to --window requests are kept in flight: 1 measures unloaded latency,
+// larger windows load the server so it answers in batches.
+//
+// Usage: serve_client <socket_path> <test_file> [--window N] [--repeat R] [--out <file>]
+
+static uint64_t nowNanos() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// MSG_NOSIGNAL: a server that closed early fails the write instead of raising SIGPIPE
+static bool writeAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = send(fd, data, length, MSG_NOSIGNAL);
+        if (written < 0 && errno == EINTR) continue;
+        if (written < 0) return false;
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::vector<const char*> args;
+    size_t window = 1;
+    size_t repeat = 1;
+    const char* outPath = nullptr;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if ((arg == "--window" || arg == "--repeat" || arg == "--out") && i + 1 < argc) {
+            const char* value = argv[++i];
+            if (arg == "--window") window = std::stoul(value);
+            else if (arg == "--repeat") repeat = std::stoul(value);
+            else outPath = value;
+        } else {
+            args.push_back(argv[i]);
+        }
+    }
+    if (args.size() != 2 || window == 0) {
+        std::cerr << "Usage: " << argv[0]
+                  << " <socket_path> <test_file> [--window N] [--repeat R] [--out <file>]" << std::endl;
+        return 1;
+    }
+
+    MappedFile testFile(args[1]);
+    if (!testFile.is_open()) {
+        std::cerr << "Unable to open " << args[1] << std::endl;
+        return 1;
+    }
+    std::vector<CsvField> rows;
+    CsvReader reader(testFile);
+    CsvField line;
+    while (reader.nextLine(line)) {
+        // The server skips blank lines and header rows without answering them
+        if (line.trimmed().empty()) continue;
+        CsvField fields[5];
+        CsvReader::splitFields(line, fields, 5);
+        if (!fields[0].equals("id")) rows.push_back(line);
+    }
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, args[0], sizeof(address.sun_path) - 1);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        std::cerr << "Unable to connect to " << args[0] << std::endl;
+        return 1;
+    }
+
+    // Answers arrive in request order, so the i-th response line belongs to request i
+    size_t total = rows.size() * repeat;
+    std::vector<uint64_t> sentAt(total);
+    std::mutex mutex;
+    std::condition_variable space;
+    size_t inFlight = 0;
+    bool closed = false;  // The server closed the connection; nothing more will be answered
+
+    uint64_t start = nowNanos();
+    std::thread sender([&]() {
+        std::string request;
+        for (size_t i = 0; i < total; i++) {
+            const CsvField& row = rows[i % rows.size()];
+            request.assign(row.data, row.length);
+            request += '\n';
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                space.wait(lock, [&]() { return inFlight < window || closed; });
+                if (closed) break;
+                inFlight++;
+                sentAt[i] = nowNanos();
+            }
+            if (!writeAll(fd, request.data(), request.size())) break;
+        }
+        shutdown(fd, SHUT_WR);  // End of input; the server answers the rest and closes
+    });
+
+    std::ofstream out;
+    if (outPath) out.open(outPath);
+    LatencyHistogram latency;
+    std::vector<char> buffer(64 * 1024);
+    std::string partial;
+    size_t answered = 0;
+    while (true) {
+        ssize_t received = read(fd, buffer.data(), buffer.size());
+        if (received < 0 && errno == EINTR) continue;
+        if (received <= 0) break;
+        uint64_t now = nowNanos();
+        partial.append(buffer.data(), static_cast<size_t>(received));
+        size_t lineStart = 0;
+        size_t newline;
+        size_t lines = 0;
+        while ((newline = partial.find('\n', lineStart)) != std::string::npos) {
+            if (out.is_open()) out.write(partial.data() + lineStart, static_cast<std::streamsize>(newline - lineStart + 1));
+            lineStart = newline + 1;
+            lines++;
+        }
+        partial.erase(0, lineStart);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < lines && answered < total; i++, answered++) {
+                latency.record(now - sentAt[answered]);
+            }
+            inFlight -= lines < inFlight ? lines : inFlight;
+        }
+        space.notify_one();
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closed = true;
+    }
+    space.notify_one();
+    double seconds = (nowNanos() - start) / 1e9;
+    sender.join();
+    close(fd);
+
+    std::cout << "requests,answered,window,seconds,requests_per_s,p50_us,p99_us,max_us\n"
+              << total << ',' << answered << ',' << window << ',' << seconds << ','
+              << (seconds > 0 ? answered / seconds : 0.0) << ','
+              << latency.percentile(0.50) / 1000.0 << ',' << latency.percentile(0.99) / 1000.0 << ','
+              << latency.max() / 1000.0 << std::endl;
+    return answered == total ? 0 : 1;
+}